@@ -23,6 +23,7 @@
 
 #include "BuffersSimulator.h"
 #include <limits>
+#include <algorithm>
 
 
 template class StandardHistoryCacheEntry<L64bu, L64bu, L64bu>;
@@ -31,6 +32,9 @@ template class InfiniteHistoryCache<L64bu, L64bu, L64bu, L64bu>;
 template class StandardHistoryCacheEntry<L64bu, L64bu, L64b>;
 template class RealHistoryCache<L64bu, L64bu, L64bu, L64b>;
 template class InfiniteHistoryCache<L64bu, L64bu, L64bu, L64b>;
+template class StandardHistoryCacheEntry<L64bu, L64b, L64bu>;
+template class RealHistoryCache<L64bu, L64bu, L64b, L64bu>;
+template class InfiniteHistoryCache<L64bu, L64bu, L64b, L64bu>;
 
 
 template<typename T, typename A, typename LA>
@@ -58,6 +62,20 @@ void StandardHistoryCacheEntry<T, A, LA>::setLastAccess(LA la) {
 	lastAccess = la;
 }
 
+template<typename T, typename A, typename LA>
+void StandardHistoryCacheEntry<T, A, LA>::save(ostream& os) {
+	writeBinary(os, this->tag);
+	writeBinary(os, this->lastAccess);
+	writeBinaryVector(os, this->history);
+}
+
+template<typename T, typename A, typename LA>
+void StandardHistoryCacheEntry<T, A, LA>::load(istream& is) {
+	readBinary(is, this->tag);
+	readBinary(is, this->lastAccess);
+	readBinaryVector(is, this->history);
+}
+
 template<typename T, typename A, typename LA>
 StandardHistoryCacheEntry<T, A, LA>::StandardHistoryCacheEntry() {
 	this->history = vector<A>();
@@ -115,36 +133,46 @@ InfiniteHistoryCache<T, I, A, LA>::InfiniteHistoryCache(int numAccesses, int num
 template<typename T, typename I, typename A, typename LA >
  bool InfiniteHistoryCache<T, I, A, LA>::getEntry(I instruction,
 	 HistoryCacheEntry<T, A, LA>* res) {
-	if (entries.find(instruction) == entries.end())
+	auto entry = findEntry(instruction);
+	if (entry == nullptr)
 		return false;
 	else {
-		auto entry = entries.find(instruction)->second;
-		entry.copy(res);
+		entry->copy(res);
 		return true;
 	}
 		
 }
 
 template<typename T, typename I, typename A, typename LA >
-bool InfiniteHistoryCache<T, I, A, LA>::newAccess(I instruction, LA access, A class_) {
-	bool res = true;
-	StandardHistoryCacheEntry<T, A, LA> entry = 
-		StandardHistoryCacheEntry<T, A, LA>(numAccesses);
-	bool entryFound	= getEntry(instruction, &entry);
-	if (!entryFound) {
-		entries[instruction] = entry;
-		res = false;
+HistoryCacheEntry<T, A, LA>* InfiniteHistoryCache<T, I, A, LA>::findEntry(I instruction) {
+	auto iter = entries.find(instruction);
+	if (iter == entries.end())
+		return nullptr;
+	return &iter->second;
+}
+
+template<typename T, typename I, typename A, typename LA >
+bool InfiniteHistoryCache<T, I, A, LA>::updateEntry(I instruction, HistoryCacheEntry<T, A, LA>* entry,
+	LA access, A class_) {
+	bool res = entry != nullptr;
+	if (!res) {
+		// The entry is allocated with an invalid history:
+		entry = &(entries[instruction] = StandardHistoryCacheEntry<T, A, LA>(numAccesses));
 	}
 	
-	entries[instruction].setEntry(instruction, access, class_);
+	entry->setEntry(instruction, access, class_);
 	return res;
 }
 
+template<typename T, typename I, typename A, typename LA >
+bool InfiniteHistoryCache<T, I, A, LA>::newAccess(I instruction, LA access, A class_) {
+	return updateEntry(instruction, findEntry(instruction), access, class_);
+}
+
 template<typename T, typename I, typename A, typename LA >
 double InfiniteHistoryCache<T, I, A, LA>::getMemoryCost() {
 	double costPerEntry = sizeof(LA); // Last access value
-	double numBitsClass = ceil(log10(this->numClasses + 1) / log10(2));
-	costPerEntry += (numAccesses * numBitsClass) / 8;
+	costPerEntry += (numAccesses * this->getNumBitsPerClass()) / 8;
 	return costPerEntry * this->entries.size();
 }
 
@@ -155,6 +183,40 @@ double InfiniteHistoryCache<T, I, A, LA>::getTotalMemoryCost() {
 	return extraCostPerEntry * this->entries.size() + getMemoryCost();
 }
 
+template<typename T, typename I, typename A, typename LA >
+void InfiniteHistoryCache<T, I, A, LA>::save(ostream& os) {
+	writeBinary(os, this->numAccesses);
+	writeBinary(os, this->numClasses);
+	writeBinary(os, (unsigned long long)this->entries.size());
+	for (auto& [instruction, entry] : this->entries) {
+		writeBinary(os, instruction);
+		entry.save(os);
+	}
+}
+
+template<typename T, typename I, typename A, typename LA >
+void InfiniteHistoryCache<T, I, A, LA>::load(istream& is) {
+	int numAccesses, numClasses;
+	readBinary(is, numAccesses);
+	readBinary(is, numClasses);
+	if (numAccesses != this->numAccesses || numClasses != this->numClasses) {
+		string msg = "ERROR: The snapshot does not match the parameters of the history cache!\n";
+		std::cout << msg;
+		throw std::invalid_argument(msg);
+	}
+
+	unsigned long long numEntries;
+	readBinary(is, numEntries);
+	this->entries.clear();
+	for (unsigned long long k = 0; k < numEntries; k++) {
+		I instruction;
+		readBinary(is, instruction);
+		// The entries are appended in order, so the hint makes the insertion constant:
+		auto it = this->entries.emplace_hint(this->entries.end(), instruction, StandardHistoryCacheEntry<T, A, LA>(numAccesses));
+		it->second.load(is);
+	}
+}
+
 template<typename T, typename A, typename LA>
 RealHistoryCacheEntry<T, A, LA>::RealHistoryCacheEntry() {
 	this->history = vector<A>();
@@ -175,11 +237,13 @@ RealHistoryCacheEntry<T, A, LA>::RealHistoryCacheEntry(int numAccesses, int way)
 template<typename T, typename A, typename LA>
 void RealHistoryCacheEntry<T, A, LA>::copy(HistoryCacheEntry<T, A, LA>* p) {
 	
-	RealHistoryCacheEntry<T, A, LA>* aux = (RealHistoryCacheEntry<T, A, LA>*) p;
-	aux->setWay(this->way);
-	aux->setHistory(this->history);
-	aux->setLastAccess(this->lastAccess);
-	aux->setTag(this->tag);
+	// The way is only copied if the destination is also the entry of a real history cache:
+	RealHistoryCacheEntry<T, A, LA>* aux = dynamic_cast<RealHistoryCacheEntry<T, A, LA>*>(p);
+	if (aux != nullptr)
+		aux->setWay(this->way);
+	p->setHistory(this->history);
+	p->setLastAccess(this->lastAccess);
+	p->setTag(this->tag);
 	
 }
 
@@ -213,6 +277,22 @@ bool RealHistoryCache<T, I, A, LA>::getEntry(I instruction,
 	return way != -1;
 }
 
+template<typename T, typename I, typename A, typename LA >
+HistoryCacheEntry<T, A, LA>* RealHistoryCache<T, I, A, LA>::findEntry(I instruction) {
+	int numTagBits = std::numeric_limits<T>::digits - numIndexBits;
+	long index = (instruction << numTagBits) >> numTagBits;
+	return this->sets[index].findEntry(instruction);
+}
+
+template<typename T, typename I, typename A, typename LA >
+bool RealHistoryCache<T, I, A, LA>::updateEntry(I instruction, HistoryCacheEntry<T, A, LA>* entry,
+	LA access, A class_) {
+	int numTagBits = std::numeric_limits<T>::digits - numIndexBits;
+	long index = (instruction << numTagBits) >> numTagBits;
+	return this->sets[index].updateEntry(instruction, static_cast<RealHistoryCacheEntry<T, A, LA>*>(entry),
+		access, class_);
+}
+
 template<typename T, typename I, typename A, typename LA >
 bool RealHistoryCache<T, I, A, LA>::newAccess(I instruction, LA access, A class_) {
 	int numTagBits = std::numeric_limits<T>::digits - numIndexBits;
@@ -223,8 +303,7 @@ bool RealHistoryCache<T, I, A, LA>::newAccess(I instruction, LA access, A class_
 template<typename T, typename I, typename A, typename LA >
 double RealHistoryCache<T, I, A, LA>::getMemoryCost() {
 	double costPerEntry = sizeof(LA); // Last access value;
-	double numBitsClass = ceil(log10(this->numClasses + 1) / log10(2));
-	costPerEntry += (this->numAccesses * numBitsClass) / 8;
+	costPerEntry += (this->numAccesses * this->getNumBitsPerClass()) / 8;
 	return costPerEntry * this->getNumEntries();
 }
 
@@ -236,6 +315,35 @@ double RealHistoryCache<T, I, A, LA>::getTotalMemoryCost() {
 	return extraCostPerEntry * this->getNumEntries() + getMemoryCost();
 }
 
+template<typename T, typename I, typename A, typename LA >
+void RealHistoryCache<T, I, A, LA>::save(ostream& os) {
+	writeBinary(os, this->numIndexBits);
+	writeBinary(os, this->numWays);
+	writeBinary(os, this->numAccesses);
+	writeBinary(os, (unsigned long long)this->sets.size());
+	for (auto& set : this->sets)
+		set.save(os);
+}
+
+template<typename T, typename I, typename A, typename LA >
+void RealHistoryCache<T, I, A, LA>::load(istream& is) {
+	int numIndexBits, numWays, numAccesses;
+	unsigned long long numSets;
+	readBinary(is, numIndexBits);
+	readBinary(is, numWays);
+	readBinary(is, numAccesses);
+	readBinary(is, numSets);
+	if (numIndexBits != this->numIndexBits || numWays != this->numWays || numAccesses != this->numAccesses
+		|| numSets != this->sets.size()) {
+		string msg = "ERROR: The snapshot does not match the parameters of the history cache!\n";
+		std::cout << msg;
+		throw std::invalid_argument(msg);
+	}
+
+	for (auto& set : this->sets)
+		set.load(is);
+}
+
 template<typename T, typename I, typename A, typename LA >
 HistoryCacheSet<T, I, A, LA>::HistoryCacheSet() {
 	this->numTagBits = -1;
@@ -261,29 +369,37 @@ HistoryCacheSet<T, I, A, LA>::HistoryCacheSet(int numWays, int numTagBits, int n
 
 template<typename T, typename I, typename A, typename LA >
 int HistoryCacheSet<T, I, A, LA>::getEntry(I instruction, HistoryCacheEntry<T, A, LA>* res) {
+	auto entry = findEntry(instruction);
+	if (entry == nullptr)
+		return -1;
+
+	entry->copy(res);
+	return entry->getWay();
+}
+
+template<typename T, typename I, typename A, typename LA >
+RealHistoryCacheEntry<T, A, LA>* HistoryCacheSet<T, I, A, LA>::findEntry(I instruction) {
 	int numIndexBits = std::numeric_limits<T>::digits - this->numTagBits;
 	T tag = instruction >> numIndexBits;
 	for (int way = 0; way < entries.size(); way++) {
-		RealHistoryCacheEntry<T, A, LA> entry = entries[way];
-		if (entry.getTag() == tag) {
-			entry.copy(res);
-			return way;
+		if (entries[way].getTag() == tag) {
+			return &entries[way];
 		}
 	}
 
-	return -1;
+	return nullptr;
 }
 
 template<typename T, typename I, typename A, typename LA >
-bool HistoryCacheSet<T, I, A, LA>::newAccess(I instruction, LA access, A class_) {
+bool HistoryCacheSet<T, I, A, LA>::updateEntry(I instruction, RealHistoryCacheEntry<T, A, LA>* entry,
+	LA access, A class_) {
 	bool res = true;
-	RealHistoryCacheEntry<T, A, LA> entry =
-		RealHistoryCacheEntry<T, A, LA>();
-
-	// We get the entry corresponding the given instruction:
-	int way = getEntry(instruction, &entry);
-	bool entryFound = way >= 0;
-	if (!entryFound) {
+	int way;
+	bool entryFound = entry != nullptr;
+	if (entryFound) {
+		way = entry->getWay();
+	}
+	else {
 		// If it is not found, we will set one of the least recent entries:
 		res = false;
 		way = getLeastRecentWay();
@@ -300,6 +416,12 @@ bool HistoryCacheSet<T, I, A, LA>::newAccess(I instruction, LA access, A class_)
 	return res;
 }
 
+template<typename T, typename I, typename A, typename LA >
+bool HistoryCacheSet<T, I, A, LA>::newAccess(I instruction, LA access, A class_) {
+	// We get the entry corresponding the given instruction and update it:
+	return updateEntry(instruction, findEntry(instruction), access, class_);
+}
+
 template<typename T, typename I, typename A, typename LA >
 int HistoryCacheSet<T, I, A, LA>::getLeastRecentWay() {
 	int tailWay = -1;
@@ -357,6 +479,38 @@ void HistoryCacheSet<T, I, A, LA>::updateLFU(int newAccessWay) {
 	
 }
 
+template<typename T, typename I, typename A, typename LA >
+void HistoryCacheSet<T, I, A, LA>::save(ostream& os) {
+	writeBinary(os, this->numTagBits);
+	writeBinary(os, this->numAccesses);
+	writeBinary(os, this->headWay);
+	writeBinary(os, (int)this->entries.size());
+	for (auto& entry : this->entries)
+		entry.save(os);
+	writeBinaryVector(os, vector<char>(this->isEntryRecentlyUsed.begin(), this->isEntryRecentlyUsed.end()));
+	writeBinaryVector(os, this->entriesConfidence);
+}
+
+template<typename T, typename I, typename A, typename LA >
+void HistoryCacheSet<T, I, A, LA>::load(istream& is) {
+	int numWays;
+	readBinary(is, this->numTagBits);
+	readBinary(is, this->numAccesses);
+	readBinary(is, this->headWay);
+	readBinary(is, numWays);
+
+	// The set is rebuilt, as it may have been cleaned:
+	this->entries = vector<RealHistoryCacheEntry<T, A, LA>>();
+	for (int way = 0; way < numWays; way++) {
+		this->entries.push_back(RealHistoryCacheEntry<T, A, LA>(this->numAccesses, way));
+		this->entries[way].load(is);
+	}
+	vector<char> isEntryRecentlyUsed;
+	readBinaryVector(is, isEntryRecentlyUsed);
+	this->isEntryRecentlyUsed = vector<bool>(isEntryRecentlyUsed.begin(), isEntryRecentlyUsed.end());
+	readBinaryVector(is, this->entriesConfidence);
+}
+
 template<typename D>
 Dictionary<D>::Dictionary() {
 	this->numClasses = 0;
@@ -392,6 +546,12 @@ int Dictionary<D>::leastReliableClass() {
 
 template<typename D>
 int Dictionary<D>::newDelta(D delta) {
+	bool classIsFound;
+	return newDelta(delta, &classIsFound);
+}
+
+template<typename D>
+int Dictionary<D>::newDelta(D delta, bool* pointer_classIsFound) {
 	int class_ = -1;
 	bool classIsFound = false;
 	for (int i = 0; i < entries.size(); i++) {
@@ -410,14 +570,14 @@ int Dictionary<D>::newDelta(D delta) {
 		
 	}
 
-	int leastReliableClass = this->leastReliableClass();
 	if(!classIsFound){
-		class_ = leastReliableClass;
+		class_ = this->leastReliableClass();
 		auto entry = &entries[class_];
 		entry->delta = delta;
 		entry->confidence = (this->maxConfidence + 1) / this->numConfidenceJumps;
 
 	}
+	*pointer_classIsFound = classIsFound;
 	return class_;
 }
 
@@ -448,6 +608,39 @@ void Dictionary<D>::showContent() {
 	cout << "-----" << endl;
 }
 
+template<typename D>
+void Dictionary<D>::save(ostream& os) {
+	writeBinary(os, this->numClasses);
+	writeBinary(os, this->maxConfidence);
+	writeBinary(os, this->numConfidenceJumps);
+	writeBinary(os, (int)this->entries.size());
+	for (auto& entry : this->entries) {
+		writeBinary(os, entry.delta);
+		writeBinary(os, entry.confidence);
+	}
+}
+
+template<typename D>
+void Dictionary<D>::load(istream& is) {
+	int numClasses, maxConfidence, numConfidenceJumps, numEntries;
+	readBinary(is, numClasses);
+	readBinary(is, maxConfidence);
+	readBinary(is, numConfidenceJumps);
+	if (numClasses != this->numClasses || maxConfidence != this->maxConfidence
+		|| numConfidenceJumps != this->numConfidenceJumps) {
+		string msg = "ERROR: The snapshot does not match the parameters of the dictionary!\n";
+		std::cout << msg;
+		throw std::invalid_argument(msg);
+	}
+
+	readBinary(is, numEntries);
+	this->entries = vector<DictionaryEntry<D>>(numEntries);
+	for (auto& entry : this->entries) {
+		readBinary(is, entry.delta);
+		readBinary(is, entry.confidence);
+	}
+}
+
 
 template<typename T, typename I, typename A, typename LA, typename Delta>
 BuffersSimulator <T, I, A, LA, Delta>::BuffersSimulator(HistoryCacheType cacheType, CacheParameters cacheParams,
@@ -469,6 +662,14 @@ BuffersSimulator <T, I, A, LA, Delta>::BuffersSimulator(HistoryCacheType cacheTy
 		this->historyCache = nullptr;
 	}
 	
+	// The classes of the histories (plus the class of non-valid accesses) have to fit in the buffers dataset,
+	// whose rows are widened to unsigned short from 255 classes on:
+	if (!BuffersDataset<A>::template canStoreClasses<unsigned short>(dictParams.numClasses)) {
+		string msg = string("ERROR: The number of classes is too big to be stored in the buffers dataset!\n");
+		std::cout << msg;
+		throw std::invalid_argument(msg);
+	}
+
 	this->dictionary = Dictionary<Delta>(dictParams.numClasses, dictParams.maxConfidence, dictParams.numConfidenceJumps);
 	this->saveHistoryAndClassAfterDictMiss = dictParams.saveHistoryAndClassIfNotValid;
 	this->saveHistoryAndClassIfNotValid = cacheParams.saveHistoryAndClassIfNotValid;
@@ -480,6 +681,8 @@ BuffersSimulator <T, I, A, LA, Delta>::BuffersSimulator(const BuffersSimulator <
 	saveHistoryAndClassAfterDictMiss = simulator.saveHistoryAndClassAfterDictMiss;
 	saveHistoryAndClassIfNotValid = simulator.saveHistoryAndClassIfNotValid;
 	numHistoryAccesses = simulator.numHistoryAccesses;
+	validateBuffers = simulator.validateBuffers;
+	recordLastAccesses = simulator.recordLastAccesses;
 	dictionary = Dictionary<Delta>(simulator.dictionary);
 	InfiniteHistoryCache<T, I, A, LA> cache = *((InfiniteHistoryCache<T, I, A, LA>*) & simulator.historyCache);
 	historyCache = shared_ptr<HistoryCache<T, I, A, LA>>(
@@ -487,132 +690,145 @@ BuffersSimulator <T, I, A, LA, Delta>::BuffersSimulator(const BuffersSimulator <
 
 }
 
+template<typename T, typename I, typename A, typename LA, typename Delta>
+void BuffersSimulator<T, I, A, LA, Delta>::save(ostream& os) {
+	writeBinary(os, this->numHistoryAccesses);
+	this->historyCache->save(os);
+	this->dictionary.save(os);
+}
+
+template<typename T, typename I, typename A, typename LA, typename Delta>
+void BuffersSimulator<T, I, A, LA, Delta>::load(istream& is) {
+	int numHistoryAccesses;
+	readBinary(is, numHistoryAccesses);
+	if (numHistoryAccesses != this->numHistoryAccesses) {
+		string msg = "ERROR: The snapshot does not match the parameters of the buffers simulator!\n";
+		std::cout << msg;
+		throw std::invalid_argument(msg);
+	}
+
+	this->historyCache->load(is);
+	this->dictionary.load(is);
+}
+
 template<typename T, typename I, typename A, typename LA, typename Delta>
 BuffersDataset<A> BuffersSimulator<T, I, A, LA, Delta>::simulate(AccessesDataset<I, LA>& dataset) {
 	// We iterate through the given samples:
-	auto accesses = dataset.accesses;
-	auto instructions = dataset.accessesInstructions;
+	auto& accesses = dataset.accesses;
+	auto& instructions = dataset.accessesInstructions;
 
-	BuffersDataset<A> res = {
-		vector<vector<A>>(),
-		vector<A>(),
-		vector<bool>(),
-		vector<bool>(),
-		vector<bool>()
-	};
+	BuffersDataset<A> res = newDataset(accesses.size());
 
 	double numFallosDiccionario = 0.0;
 
 	for (int k = 0; k < accesses.size(); k++) {
-		auto access = accesses[k];
-		auto instruction = instructions[k];
+		numFallosDiccionario += simulateAccess(instructions[k], accesses[k], res);
+	}
 
-		vector<A> inputAccesses = vector<A>();
-		A outputAccess;
-		bool isValid = true,
-			isCacheMiss = false,
-			isDictionaryMiss = false;
-
-		// First, we ask the cache for the respective instruction history:
-		bool historyIsValid = true;
-		shared_ptr<HistoryCacheEntry<T, A, LA>> history = 
-			shared_ptr< HistoryCacheEntry<T, A, LA>>(new StandardHistoryCacheEntry<T, A, LA>());
-		bool historyIsFound = historyCache->getEntry(instruction, history.get());
-		Delta delta;
-		LA previousAccess;
-		if (historyIsFound) {
-			historyIsValid = history->isEntryValid();
-			previousAccess = history->getLastAccess();
-			delta = access - previousAccess;
-		}
-		else {
-			historyIsValid = false;
-			previousAccess = access;
-			delta = 0;
-		}
+	printf("\nFallos de diccionario: %f", (double)numFallosDiccionario / accesses.size());
 
-		
+	return res;
 
-		// The history and the dictionary are updated:
-		bool classIsFound;
-		int class_;
-		if (historyIsFound) {
+}
 
-			// First, we ask the dictionary for the class/word assigned to the delta of the access:
-			class_ = dictionary.getClass(delta);
-			classIsFound = class_ >= 0;
+template<typename T, typename I, typename A, typename LA, typename Delta>
+BuffersDataset<A> BuffersSimulator<T, I, A, LA, Delta>::newDataset(size_t numAccesses) {
+	BuffersDataset<A> res = BuffersDataset<A>(this->numHistoryAccesses, this->dictionary.numClasses, this->recordLastAccesses);
+	res.reserve(numAccesses);
 
-			class_ = dictionary.newDelta(delta);
-		}
-		else {
-			classIsFound = false;
-			class_ = -1;
-		}
-		historyCache->newAccess(instruction, access, class_);
+	// The dictionary may already be warm (e.g. after a previous chunk of the trace):
+	for (int c = 0; c < this->dictionary.entries.size(); c++)
+		res.recordClassDelta(-1, c, (L64b)this->dictionary.entries[c].delta);
+	return res;
+}
 
-		
-		bool noError = true;
-		// isCacheMiss = !historyIsValid;
-		isCacheMiss = !historyIsFound;
-		isDictionaryMiss = !classIsFound;
-		vector<A> history_ = history->getHistory();
-
-		// If we predict via greediness, histories that are found but not valid will be saved:
-		if (!isCacheMiss && !historyIsValid && this->saveHistoryAndClassIfNotValid) {
-			historyIsValid = true;
-			vector<A> aux = vector<A>();
-			for (A elem : history_)
-				aux.push_back(elem == -1? this->dictionary.numClasses : elem);
-			history_ = aux;
-		}
+template<typename T, typename I, typename A, typename LA, typename Delta>
+bool BuffersSimulator<T, I, A, LA, Delta>::simulateAccess(I instruction, LA access, BuffersDataset<A>& res) {
+	A outputAccess;
+	bool isValid = true,
+		isCacheMiss = false,
+		isDictionaryMiss = false;
 
-		inputAccesses = vector<A>(history_);
-		if (!classIsFound || !historyIsValid || !historyIsFound) {
-			// The access is labeled as miss:
-			isValid = false;
-			if (!historyIsValid || !saveHistoryAndClassAfterDictMiss) {
-				outputAccess = -1;
-			}
-			else {
-				// In the case that only the dictionary, failed, we
-				// will indicate as resulting class the class for
-				// the next iteration after updating the dictionary:
-				outputAccess = class_;
-			}
+	// First, we probe the cache (only once) for the respective instruction history:
+	bool historyIsValid = true;
+	HistoryCacheEntry<T, A, LA>* history = historyCache->findEntry(instruction);
+	bool historyIsFound = history != nullptr;
+	Delta delta;
+	LA previousAccess;
+	if (historyIsFound) {
+		historyIsValid = history->isEntryValid();
+		previousAccess = history->getLastAccess();
+		delta = access - previousAccess;
+	}
+	else {
+		historyIsValid = false;
+		previousAccess = access;
+		delta = 0;
+	}
 
-			// We test the buffers just in case:
-			noError = this->testBuffers(instruction, access, previousAccess);
+	// The dictionary is updated:
+	bool classIsFound;
+	int class_;
+	if (historyIsFound) {
 
-			if (!noError)
-				cout << "ERROR" << endl;
-			
+		// The dictionary gives the class/word assigned to the delta of the access, and
+		// tells us whether it was already known:
+		class_ = dictionary.newDelta(delta, &classIsFound);
+	}
+	else {
+		classIsFound = false;
+		class_ = -1;
+	}
+
+	// isCacheMiss = !historyIsValid;
+	isCacheMiss = !historyIsFound;
+	isDictionaryMiss = !classIsFound;
+
+	// If we predict via greediness, histories that are found but not valid will be saved:
+	bool replaceInvalidClasses = false;
+	if (!isCacheMiss && !historyIsValid && this->saveHistoryAndClassIfNotValid) {
+		historyIsValid = true;
+		replaceInvalidClasses = true;
+	}
+
+	if (!classIsFound || !historyIsValid || !historyIsFound) {
+		// The access is labeled as miss:
+		isValid = false;
+		if (!historyIsValid || !saveHistoryAndClassAfterDictMiss) {
+			outputAccess = -1;
 		}
 		else {
-			isValid = true;
+			// In the case that only the dictionary, failed, we
+			// will indicate as resulting class the class for
+			// the next iteration after updating the dictionary:
 			outputAccess = class_;
-
-			// We test the buffers just in case:
-			noError = this->testBuffers(instruction, access, previousAccess);
-
-			if (!noError)
-				cout << "ERROR" << endl;
 		}
-
-		res.inputAccesses.push_back(inputAccesses);
-		res.outputAccesses.push_back(outputAccess);
-		res.isValid.push_back(isValid);
-		res.isDictionaryMiss.push_back(isDictionaryMiss);
-		res.isCacheMiss.push_back(isCacheMiss);
-
-		numFallosDiccionario += isDictionaryMiss;
-
-		history.reset();
+	}
+	else {
+		isValid = true;
+		outputAccess = class_;
 	}
 
-	printf("\nFallos de diccionario: %f", (double)numFallosDiccionario / accesses.size());
+	// The history is saved in the dataset before being updated (it stays invalid after a cache miss):
+	res.push_back(outputAccess, isCacheMiss, isDictionaryMiss, isValid, (L64bu)previousAccess);
+	if (historyIsFound && !classIsFound)
+		res.recordClassDelta(res.size() - 1, class_, (L64b)delta);
+	if (historyIsFound) {
+		auto& history_ = history->peekHistory();
+		for (int j = 0; j < history_.size(); j++) {
+			A elem = history_[j];
+			if (replaceInvalidClasses && elem == -1)
+				elem = this->dictionary.numClasses;
+			res.setInputAccess(res.size() - 1, j, elem);
+		}
+	}
+	historyCache->updateEntry(instruction, history, access, class_);
 
-	return res;
+	// We test the buffers just in case (only in validation mode):
+	if (this->validateBuffers && !this->testBuffers(instruction, access, previousAccess))
+		cout << "ERROR" << endl;
 
+	return isDictionaryMiss;
 }
 
 template<typename T, typename I, typename A, typename LA, typename Delta>
@@ -676,4 +892,118 @@ proposedBuffersSimulator(AccessesDataset<L64bu, L64bu>& dataset, BuffersDataset<
 	return res;
 }
 
+template<typename T, typename I, typename A, typename LA, typename Delta>
+void MultiBuffersSimulator<T, I, A, LA, Delta>::addSimulator(BuffersSimulator<T, I, A, LA, Delta>* simulator) {
+	this->simulators.push_back(simulator);
+}
+
+template<typename T, typename I, typename A, typename LA, typename Delta>
+vector<BuffersDataset<A>> MultiBuffersSimulator<T, I, A, LA, Delta>::simulate(AccessesDataset<I, LA>& dataset) {
+	auto& accesses = dataset.accesses;
+	auto& instructions = dataset.accessesInstructions;
+	int numSimulators = this->simulators.size();
+
+	vector<BuffersDataset<A>> res = vector<BuffersDataset<A>>();
+	for (auto simulator : this->simulators)
+		res.push_back(simulator->newDataset(accesses.size()));
+	vector<double> numFallosDiccionario = vector<double>(numSimulators, 0.0);
+
+	// Every access is decoded once and then dispatched to all the simulators in lock-step:
+	for (int k = 0; k < accesses.size(); k++) {
+		auto access = accesses[k];
+		auto instruction = instructions[k];
+		for (int s = 0; s < numSimulators; s++) {
+			numFallosDiccionario[s] += this->simulators[s]->simulateAccess(instruction, access, res[s]);
+		}
+	}
+
+	for (int s = 0; s < numSimulators; s++) {
+		printf("\nFallos de diccionario (%d): %f", s, numFallosDiccionario[s] / accesses.size());
+	}
+
+	return res;
+}
+
+template<typename T, typename I>
+HistoryCacheGeometryAnalyzer<T, I>::HistoryCacheGeometryAnalyzer() {
+	this->numAccesses = 0;
+}
+
+template<typename T, typename I>
+HistoryCacheGeometryAnalyzer<T, I>::HistoryCacheGeometryAnalyzer(CacheParametersDomain domain) {
+	for (int numIndexBits : domain.numIndexBits) {
+		for (int numWays : domain.numWays) {
+			// As in RealHistoryCache, the tags need at least one index bit (and a negative one is an infinite cache):
+			if (numIndexBits == 0 || numIndexBits >= std::numeric_limits<T>::digits || numWays < 1) {
+				string msg = "ERROR: Invalid cache geometry for the analysis!\n";
+				std::cout << msg;
+				throw std::invalid_argument(msg);
+			}
+			this->geometries.push_back({ numIndexBits, numWays });
+		}
+	}
+	this->clean();
+}
+
+template<typename T, typename I>
+int HistoryCacheGeometryAnalyzer<T, I>::getGeometryIndex(int numIndexBits, int numWays) {
+	for (size_t g = 0; g < this->geometries.size(); g++) {
+		if (this->geometries[g] == pair<int, int>(numIndexBits, numWays))
+			return (int)g;
+	}
+
+	string msg = "ERROR: The cache geometry has not been analyzed!\n";
+	std::cout << msg;
+	throw std::invalid_argument(msg);
+}
+
+template<typename T, typename I>
+void HistoryCacheGeometryAnalyzer<T, I>::newAccess(I instruction) {
+	// The caches are probed and updated as the buffers simulator does, but without classes:
+	for (size_t g = 0; g < this->caches.size(); g++) {
+		auto entry = this->caches[g]->findEntry(instruction);
+		if (entry == nullptr)
+			this->numCacheMisses[g]++;
+		this->caches[g]->updateEntry(instruction, entry, 0, 0);
+	}
+	this->numAccesses++;
+}
+
+template<typename T, typename I>
+long HistoryCacheGeometryAnalyzer<T, I>::getNumCacheMisses(int numIndexBits, int numWays) {
+	return this->numCacheMisses[getGeometryIndex(numIndexBits, numWays)];
+}
+
+template<typename T, typename I>
+double HistoryCacheGeometryAnalyzer<T, I>::getCacheMissRate(int numIndexBits, int numWays) {
+	long numMisses = getNumCacheMisses(numIndexBits, numWays);
+	return numAccesses > 0 ? (double)numMisses / numAccesses : 0.0;
+}
+
+template<typename T, typename I>
+map<pair<int, int>, double> HistoryCacheGeometryAnalyzer<T, I>::getCacheMissRates() {
+	map<pair<int, int>, double> res;
+	for (auto& geometry : this->geometries)
+		res[geometry] = getCacheMissRate(geometry.first, geometry.second);
+	return res;
+}
+
+template<typename T, typename I>
+void HistoryCacheGeometryAnalyzer<T, I>::clean() {
+	this->caches = vector<shared_ptr<HistoryCache<T, I, int, I>>>();
+	for (auto& [numIndexBits, numWays] : this->geometries) {
+		if (numIndexBits >= 0)
+			this->caches.push_back(shared_ptr<HistoryCache<T, I, int, I>>(
+				new RealHistoryCache<T, I, int, I>(numIndexBits, numWays, 1, 1)));
+		else
+			this->caches.push_back(shared_ptr<HistoryCache<T, I, int, I>>(
+				new InfiniteHistoryCache<T, I, int, I>(1, 1)));
+	}
+	this->numCacheMisses = vector<long>(this->geometries.size(), 0);
+	this->numAccesses = 0;
+}
 
+template class Dictionary<L64b>;
+template class BuffersSimulator<L64bu, L64bu, int, L64bu, L64b>;
+template class MultiBuffersSimulator<L64bu, L64bu, int, L64bu, L64b>;
+template class HistoryCacheGeometryAnalyzer<L64bu, L64bu>;
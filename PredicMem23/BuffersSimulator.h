@@ -12,8 +12,10 @@
 /// - InfiniteHistoryCache
 /// - RealHistoryCache
 /// - HistoryCacheSet
+/// - HistoryCacheGeometryAnalyzer
 /// - Dictionary
 /// - BuffersSimulator
+/// - MultiBuffersSimulator
 /// - proposedBuffersSimulator
 ///
 /// @section LICENSE
@@ -91,6 +93,19 @@ public:
 	 */
 	virtual vector<A> getHistory() = 0;
 
+	/**
+	 * @brief Get a reference to the history of accesses, without copying it.
+	 * @return The history of accesses.
+	 */
+	virtual const vector<A>& peekHistory() = 0;
+
+	/**
+	 * @brief Overwrite an element of the history in place.
+	 * @param index Position of the element in the history.
+	 * @param value The new value of the element.
+	 */
+	virtual void setHistoryValue(int index, A value) = 0;
+
 	/**
 	 * @brief Set the history of accesses.
 	 * @param history The history of accesses to set.
@@ -191,6 +206,21 @@ public:
 	 * @return The history of accesses.
 	 */
 	vector<A> getHistory();
+	/**
+	 * @brief Get a reference to the history of accesses, without copying it.
+	 * @return The history of accesses.
+	 */
+	const vector<A>& peekHistory() {
+		return history;
+	}
+	/**
+	 * @brief Overwrite an element of the history in place.
+	 * @param index Position of the element in the history.
+	 * @param value The new value of the element.
+	 */
+	void setHistoryValue(int index, A value) {
+		history[index] = value;
+	}
 	/**
 	 * @brief Set the history of accesses.
 	 * @param h The history of accesses to set.
@@ -224,6 +254,17 @@ public:
 		// this->~StandardHistoryCacheEntry();
 	}
 
+	/**
+	 * @brief Write the state of the entry into a binary snapshot.
+	 * @param os Output stream of the snapshot.
+	 */
+	void save(ostream& os);
+	/**
+	 * @brief Restore the state of the entry from a binary snapshot written by save.
+	 * @param is Input stream of the snapshot.
+	 */
+	void load(istream& is);
+
 	/*
 	int getWay() {
 		return -1;
@@ -346,6 +387,23 @@ public:
 	 */
 	int getEntry(I instruction, HistoryCacheEntry<T, A, LA>* res);
 
+	/**
+	 * @brief Find the entry of an instruction in the cache set without copying it.
+	 * @param instruction Instruction to find the entry for.
+	 * @return Pointer to the entry stored in the set, or nullptr if it is not found.
+	 */
+	RealHistoryCacheEntry<T, A, LA>* findEntry(I instruction);
+
+	/**
+	 * @brief Update an entry previously found with findEntry, or replace the least recent one.
+	 * @param instruction Instruction to register.
+	 * @param entry Entry returned by findEntry for the instruction (nullptr if it was not found).
+	 * @param access Access to register.
+	 * @param class_ Class to register.
+	 * @return True if the entry was found and updated, false otherwise.
+	 */
+	bool updateEntry(I instruction, RealHistoryCacheEntry<T, A, LA>* entry, LA access, A class_);
+
 	/**
 	 * @brief Register a new access in the cache set.
 	 * @param instruction Instruction to register.
@@ -392,6 +450,17 @@ public:
 		entries = vector<RealHistoryCacheEntry<T, A, LA>>();
 		isEntryRecentlyUsed.clear();
 	}
+
+	/**
+	 * @brief Write the state of the cache set into a binary snapshot.
+	 * @param os Output stream of the snapshot.
+	 */
+	void save(ostream& os);
+	/**
+	 * @brief Restore the state of the cache set from a binary snapshot written by save.
+	 * @param is Input stream of the snapshot.
+	 */
+	void load(istream& is);
 };
 
 
@@ -414,6 +483,24 @@ public:
 	 * @return True if the entry is found, false otherwise.
 	 */
 	virtual bool getEntry(I instruction, HistoryCacheEntry<T, A, LA>* res) = 0;
+	/**
+	 * @brief Find the entry of an instruction in place, without copying it.
+	 * @param instruction Instruction to find the entry for.
+	 * @return Pointer to the stored entry, or nullptr if it is not found.
+	 */
+	virtual HistoryCacheEntry<T, A, LA>* findEntry(I instruction) = 0;
+	/**
+	 * @brief Register a new access on an entry previously returned by findEntry.
+	 *
+	 * It allows probing the cache only once per access: the entry is read with findEntry
+	 * and then updated in place (or allocated, if it was not found) with this method.
+	 * @param instruction Instruction to register.
+	 * @param entry Entry returned by findEntry for the instruction (nullptr if it was not found).
+	 * @param access Access to register.
+	 * @param class_ Class to register.
+	 * @return True if the entry was found and updated, false otherwise.
+	 */
+	virtual bool updateEntry(I instruction, HistoryCacheEntry<T, A, LA>* entry, LA access, A class_) = 0;
 	/**
 	 * @brief Register a new access in the history cache.
 	 * @param I Instruction to register.
@@ -442,6 +529,24 @@ public:
 	 * @return The total memory cost.
 	 */
 	virtual double getTotalMemoryCost() = 0;
+	/**
+	 * @brief Set the number of bits stored for each element of the histories, used by the memory costs.
+	 * @param numBitsPerClass Number of bits per element (-1 to derive them from the number of classes).
+	 */
+	virtual void setNumBitsPerClass(int numBitsPerClass) = 0;
+
+	/**
+	 * @brief Write the state of the history cache into a binary snapshot.
+	 * @param os Output stream of the snapshot.
+	 */
+	virtual void save(ostream& os) = 0;
+	/**
+	 * @brief Restore the state of the history cache from a binary snapshot written by save.
+	 *
+	 * The snapshot must have been taken from a cache with the same parameters.
+	 * @param is Input stream of the snapshot.
+	 */
+	virtual void load(istream& is) = 0;
 };
 
 /**
@@ -466,6 +571,17 @@ private:
 protected:
 	int numAccesses; ///< Number of accesses.
 	int numClasses; ///< Number of classes.
+	int numBitsPerClass = -1; ///< Bits stored for each element of the histories (-1 to derive them from numClasses).
+
+	/**
+	 * @brief Get the number of bits stored for each element of the histories.
+	 * @return The number of bits per element.
+	 */
+	double getNumBitsPerClass() {
+		if (this->numBitsPerClass >= 0)
+			return this->numBitsPerClass;
+		return ceil(log10(this->numClasses + 1) / log10(2));
+	}
 public:
 
 	/**
@@ -496,6 +612,21 @@ public:
 	 * @return True if the entry is found, false otherwise.
 	 */
 	bool getEntry(I instruction, HistoryCacheEntry<T, A, LA>* res);
+	/**
+	 * @brief Find the entry of an instruction in the infinite history cache without copying it.
+	 * @param instruction Instruction to find the entry for.
+	 * @return Pointer to the stored entry, or nullptr if it is not found.
+	 */
+	HistoryCacheEntry<T, A, LA>* findEntry(I instruction);
+	/**
+	 * @brief Register a new access on an entry previously returned by findEntry.
+	 * @param instruction Instruction to register.
+	 * @param entry Entry returned by findEntry for the instruction (nullptr if it was not found).
+	 * @param access Access to register.
+	 * @param class_ Class to register.
+	 * @return True if the entry was found and updated, false otherwise.
+	 */
+	bool updateEntry(I instruction, HistoryCacheEntry<T, A, LA>* entry, LA access, A class_);
 	/**
 	 * @brief Register a new access in the infinite history cache.
 	 * @param instruction Instruction to register.
@@ -514,6 +645,13 @@ public:
 	 * @return The total memory cost.
 	 */
 	double getTotalMemoryCost();
+	/**
+	 * @brief Set the number of bits stored for each element of the histories, used by the memory costs.
+	 * @param numBitsPerClass Number of bits per element (-1 to derive them from the number of classes).
+	 */
+	void setNumBitsPerClass(int numBitsPerClass) {
+		this->numBitsPerClass = numBitsPerClass;
+	}
 
 	/**
 	 * @brief Clean the infinite history cache.
@@ -522,6 +660,17 @@ public:
 		entries.clear();
 	}
 
+	/**
+	 * @brief Write the state of the infinite history cache into a binary snapshot.
+	 * @param os Output stream of the snapshot.
+	 */
+	void save(ostream& os);
+	/**
+	 * @brief Restore the state of the infinite history cache from a binary snapshot written by save.
+	 * @param is Input stream of the snapshot.
+	 */
+	void load(istream& is);
+
 	/**
 	 * @brief Get the number of entries in the infinite history cache.
 	 * @return The number of entries.
@@ -578,6 +727,21 @@ public:
 	 * @return True if the entry is found, false otherwise.
 	 */
 	bool getEntry(I instruction, HistoryCacheEntry<T, A, LA>* res);
+	/**
+	 * @brief Find the entry of an instruction in the real history cache without copying it.
+	 * @param instruction Instruction to find the entry for.
+	 * @return Pointer to the stored entry, or nullptr if it is not found.
+	 */
+	HistoryCacheEntry<T, A, LA>* findEntry(I instruction);
+	/**
+	 * @brief Register a new access on an entry previously returned by findEntry.
+	 * @param instruction Instruction to register.
+	 * @param entry Entry returned by findEntry for the instruction (nullptr if it was not found).
+	 * @param access Access to register.
+	 * @param class_ Class to register.
+	 * @return True if the entry was found and updated, false otherwise.
+	 */
+	bool updateEntry(I instruction, HistoryCacheEntry<T, A, LA>* entry, LA access, A class_);
 	/**
 	 * @brief Register a new access in the real history cache.
 	 * @param instruction Instruction to register.
@@ -596,6 +760,13 @@ public:
 	 * @return The total memory cost.
 	 */
 	double getTotalMemoryCost();
+	/**
+	 * @brief Set the number of bits stored for each element of the histories, used by the memory costs.
+	 * @param numBitsPerClass Number of bits per element (-1 to derive them from the number of classes).
+	 */
+	void setNumBitsPerClass(int numBitsPerClass) {
+		InfiniteHistoryCache<T, I, A, LA>::setNumBitsPerClass(numBitsPerClass);
+	}
 
 	/**
 	 * @brief Clean the real history cache.
@@ -607,6 +778,17 @@ public:
 			set.clean();
 	}
 
+	/**
+	 * @brief Write the state of the real history cache into a binary snapshot.
+	 * @param os Output stream of the snapshot.
+	 */
+	void save(ostream& os);
+	/**
+	 * @brief Restore the state of the real history cache from a binary snapshot written by save.
+	 * @param is Input stream of the snapshot.
+	 */
+	void load(istream& is);
+
 	/**
 	 * @brief Get the number of ways in the real history cache.
 	 * @return The number of ways.
@@ -642,6 +824,97 @@ public:
 };
 
 
+/**
+ * @brief Class to obtain the cache-miss rates of many history cache geometries in a single pass.
+ *
+ * Every (numIndexBits, numWays) geometry of a domain is replayed on its own tag-only history cache
+ * (a RealHistoryCache with one-element histories, or an InfiniteHistoryCache for a negative numIndexBits),
+ * so the misses are exactly those of the buffers simulator with the same geometry, recently-used bits
+ * replacement included, without simulating the dictionary nor the models. Note that the recently-used bits
+ * are not a stack algorithm (a cache with more ways does not always hold the entries of one with fewer),
+ * so the misses of all the associativities cannot be derived from the LRU stack distances of a single cache.
+ *
+ * @tparam T Type of the tag.
+ * @tparam I Type of the instruction.
+ */
+template<typename T, typename I>
+class HistoryCacheGeometryAnalyzer {
+protected:
+	vector<pair<int, int>> geometries; ///< Analyzed (numIndexBits, numWays) geometries.
+	vector<shared_ptr<HistoryCache<T, I, int, I>>> caches; ///< Tag-only history cache of every geometry.
+	vector<long> numCacheMisses; ///< Number of cache misses of every geometry.
+	long numAccesses; ///< Number of analyzed accesses.
+
+	/**
+	 * @brief Get the position of a geometry among the analyzed ones.
+	 * @param numIndexBits Number of index bits (negative for an infinite cache).
+	 * @param numWays Number of ways.
+	 * @return The position of the geometry.
+	 */
+	int getGeometryIndex(int numIndexBits, int numWays);
+
+public:
+	/**
+	 * @brief Default constructor.
+	 */
+	HistoryCacheGeometryAnalyzer();
+	/**
+	 * @brief Constructor covering all the geometries of a cache parameters domain.
+	 * @param domain Domain of cache parameters (a negative numIndexBits stands for an infinite cache).
+	 */
+	HistoryCacheGeometryAnalyzer(CacheParametersDomain domain);
+
+	/**
+	 * @brief Register a new access in all the analyzed geometries.
+	 * @param instruction Instruction of the access.
+	 */
+	void newAccess(I instruction);
+
+	/**
+	 * @brief Register all the accesses of a dataset.
+	 * @param dataset The dataset containing the accesses.
+	 */
+	template<typename LA>
+	void analyze(AccessesDataset<I, LA>& dataset) {
+		for (auto instruction : dataset.accessesInstructions)
+			newAccess(instruction);
+	}
+
+	/**
+	 * @brief Get the number of cache misses of a geometry.
+	 * @param numIndexBits Number of index bits.
+	 * @param numWays Number of ways.
+	 * @return The number of cache misses.
+	 */
+	long getNumCacheMisses(int numIndexBits, int numWays);
+	/**
+	 * @brief Get the cache-miss rate of a geometry.
+	 * @param numIndexBits Number of index bits.
+	 * @param numWays Number of ways.
+	 * @return The cache-miss rate.
+	 */
+	double getCacheMissRate(int numIndexBits, int numWays);
+	/**
+	 * @brief Get the cache-miss rates of all the analyzed geometries.
+	 * @return Map from (numIndexBits, numWays) to cache-miss rate.
+	 */
+	map<pair<int, int>, double> getCacheMissRates();
+
+	/**
+	 * @brief Get the number of analyzed accesses.
+	 * @return The number of accesses.
+	 */
+	long getNumAccesses() {
+		return this->numAccesses;
+	}
+
+	/**
+	 * @brief Clean the analyzer (empty caches), keeping the analyzed geometries.
+	 */
+	void clean();
+};
+
+
 /**
  * @brief Struct representing a dictionary entry.
  *
@@ -697,6 +970,13 @@ public:
 	 * @return The class of the delta.
 	 */
 	int newDelta(D delta);
+	/**
+	 * @brief Register a new delta in the dictionary, reporting if it was already stored.
+	 * @param delta The delta to register.
+	 * @param classIsFound Pointer to store whether the delta already had a class before registering it.
+	 * @return The class of the delta.
+	 */
+	int newDelta(D delta, bool* classIsFound);
 	/**
 	 * @brief Get the class of a given delta.
 	 * @param delta The delta to get the class for.
@@ -725,11 +1005,34 @@ public:
 		return (extraCostPerEntry / 8) * this->entries.size() + getMemoryCost();
 	}
 
+	/**
+	 * @brief Write the state of the dictionary into a binary snapshot.
+	 * @param os Output stream of the snapshot.
+	 */
+	void save(ostream& os);
+	/**
+	 * @brief Restore the state of the dictionary from a binary snapshot written by save.
+	 * @param is Input stream of the snapshot.
+	 */
+	void load(istream& is);
+
 	// Dictionary copy();
 
 };
 
 
+/**
+ * @brief Default value of BuffersSimulator::validateBuffers.
+ *
+ * Define VALIDATE_BUFFERS at compile time to test the consistency of the buffers
+ * after every simulated access (debug builds). Otherwise, the test is skipped.
+ */
+#ifdef VALIDATE_BUFFERS
+#define VALIDATE_BUFFERS_BY_DEFAULT true
+#else
+#define VALIDATE_BUFFERS_BY_DEFAULT false
+#endif
+
 /**
  * @brief Class for simulating buffer accesses.
  *
@@ -747,6 +1050,8 @@ public:
 	int numHistoryAccesses; ///< Number of history accesses.
 	bool saveHistoryAndClassAfterDictMiss; ///< Flag to save history and class after dictionary miss.
 	bool saveHistoryAndClassIfNotValid; ///< Flag to save history and class if not valid.
+	bool validateBuffers = VALIDATE_BUFFERS_BY_DEFAULT; ///< Flag to test the buffers for consistency after every access.
+	bool recordLastAccesses = false; ///< Flag to record the last accesses and the deltas of the classes in the datasets (to prefetch).
 
 	/**
 	 * @brief Default constructor.
@@ -788,14 +1093,50 @@ public:
 		this->dictionary.~Dictionary();
 	}
 
+	/**
+	 * @brief Write the state of the history cache and the dictionary into a binary snapshot.
+	 * @param os Output stream of the snapshot.
+	 */
+	void save(ostream& os);
+	/**
+	 * @brief Restore the state of the history cache and the dictionary from a binary snapshot written by save.
+	 *
+	 * The snapshot must have been taken from a simulator with the same parameters, so that
+	 * a later chunk of a trace can continue from the warm buffers of the previous one.
+	 * @param is Input stream of the snapshot.
+	 */
+	void load(istream& is);
+
 	/**
 	 * @brief Simulate buffer accesses.
+	 *
+	 * The history cache and the dictionary are probed only once per access. The consistency
+	 * test of the buffers (testBuffers) is only performed if validateBuffers is set.
 	 * @param dataset The dataset containing the accesses.
 	 * @return The result of the simulation as BuffersDataset<A>.
 	 */
 	BuffersDataset<A> simulate(AccessesDataset<I, LA>& dataset);
 	// void simulate(AccessesDataset<I, LA> dataset, BuffersDataset<A>&);
 
+	/**
+	 * @brief Create an empty dataset for the results of this simulator.
+	 *
+	 * If the last accesses are recorded, the deltas of the classes of the dictionary before the first access
+	 * are logged in it too.
+	 * @param numAccesses Number of accesses to reserve memory for.
+	 * @return The dataset.
+	 */
+	BuffersDataset<A> newDataset(size_t numAccesses);
+
+	/**
+	 * @brief Simulate a single buffer access and append its result to a dataset.
+	 * @param instruction The instruction of the access.
+	 * @param access The accessed address.
+	 * @param res The dataset where the resulting input/output sample is appended.
+	 * @return True if the access was a dictionary miss, false otherwise.
+	 */
+	bool simulateAccess(I instruction, LA access, BuffersDataset<A>& res);
+
 	/**
 	 * @brief Test the buffers for consistency.
 	 * @param instruction The instruction to test.
@@ -823,6 +1164,46 @@ public:
 	// BuffersSimulator<T,I,A,LA> copy();
 };
 
+
+/**
+ * @brief Class for simulating several buffer configurations in a single pass.
+ *
+ * The accesses of the dataset are read once and dispatched, in lock-step, to every
+ * registered BuffersSimulator, so that a sweep over cache/dictionary parameters does
+ * not have to go through the trace once per configuration.
+ *
+ * @tparam T Type of the tag.
+ * @tparam I Type of the instruction.
+ * @tparam A Type of the access.
+ * @tparam LA Type of the last access.
+ * @tparam Delta Type of the delta.
+ */
+template<typename T, typename I, typename A, typename LA, typename Delta>
+class MultiBuffersSimulator {
+public:
+	vector<BuffersSimulator<T, I, A, LA, Delta>*> simulators; ///< Simulated configurations (not owned).
+
+	/**
+	 * @brief Default constructor.
+	 */
+	MultiBuffersSimulator() {
+		this->simulators = vector<BuffersSimulator<T, I, A, LA, Delta>*>();
+	}
+
+	/**
+	 * @brief Register a buffers simulator to be run in the shared pass.
+	 * @param simulator Pointer to the simulator. It must outlive this object.
+	 */
+	void addSimulator(BuffersSimulator<T, I, A, LA, Delta>* simulator);
+
+	/**
+	 * @brief Simulate every registered configuration over the same dataset.
+	 * @param dataset The dataset containing the accesses.
+	 * @return One BuffersDataset<A> per registered simulator, in registration order.
+	 */
+	vector<BuffersDataset<A>> simulate(AccessesDataset<I, LA>& dataset);
+};
+
 /**
  * @brief Function to create and configure a proposed BuffersSimulator.
  *
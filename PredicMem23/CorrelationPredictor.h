@@ -0,0 +1,461 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//    Copyright (c) 2024  Pablo Snchez Cuevas                    //
+//                                                                             //
+//    This file is part of PredicMem23.                                            //
+//                                                                             //
+//    PredicMem23 is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by     //
+//    the Free Software Foundation, either version 3 of the License, or        //
+//    (at your option) any later version.                                      //
+//                                                                             //
+//    PredicMem23 is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the              //
+//    GNU General Public License for more details.                             //
+//                                                                             //
+//    You should have received a copy of the GNU General Public License        //
+//    along with PredicMem23. If not, see <
+// http://www.gnu.org/licenses/>.
+//
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include "BuffersSimulator.h"
+#include "Global.h"
+#include "PredictorModel.h"
+#include "PrefetchCacheSimulator.h"
+
+using namespace std;
+
+/**
+ * @brief CorrelationPredictor Class that implements the delta-correlation predictors DCPT and GHB (PC/DC).
+ *
+ * Both designs look for the last pair of deltas of an instruction in its older deltas, and predict the delta that
+ * followed the most recent occurrence of the pair. DCPT (delta-correlating prediction tables) keeps the last deltas
+ * in the entry of the instruction table, followed by the number of them that are valid. GHB keeps the accesses in a
+ * global ring buffer, where each access is linked to the previous one of its instruction, and the entry of the
+ * instruction table only points to its last access. Both only correlate the deltas actually seen by the instruction.
+ *
+ * @tparam T Type of instruction and access data.
+ * @tparam Delta Type representing the delta between two accesses.
+ */
+template<typename T, typename Delta>
+class CorrelationPredictor : public PredictorModel<T, int> {
+protected:
+    /**
+     * @brief Entry of the global history buffer.
+     */
+    struct HistoryBufferEntry {
+        T access; ///< Access of the entry.
+        Delta link; ///< Position of the previous access of the same instruction (-1 if none).
+    };
+
+    int numPartsToPrint = 10000; /**< Number of parts to print during simulation for progress tracking. */
+    AccessesDataset<T, T> data; /**< The dataset of accesses. */
+
+    HistoryCacheEntry<T, Delta, T>* tableEntry = nullptr; /**< Entry of the last probed instruction (nullptr if missing). */
+    T probedInstruction = 0; /**< Instruction of the last probe. */
+    bool isProbeValid = false; /**< Whether the entry of the last probe still points to the current table slot. */
+
+    vector<Delta> deltasBuffer; /**< Deltas gathered from the global history buffer (oldest first), reused between accesses. */
+
+    /**
+     * @brief Probe the instruction table, keeping a reference to the slot found.
+     *
+     * predict and fit of the same access share this probe, and the table is updated in place through the reference.
+     *
+     * @param instruction The instruction to look up.
+     */
+    void probeTable(T instruction) {
+        this->tableEntry = this->instructionTable->findEntry(instruction);
+        this->probedInstruction = instruction;
+        this->isProbeValid = true;
+    }
+
+    /**
+     * @brief Check whether a position still holds its access in the global history buffer.
+     * @param position The position to check.
+     * @return True if the access at the position has not been overwritten.
+     */
+    bool isInHistoryBuffer(Delta position) {
+        return position >= 0 && position >= this->historyBufferHead - (Delta)this->historyBuffer.size();
+    }
+
+    /**
+     * @brief Find the delta that followed the most recent earlier occurrence of the last pair of deltas.
+     *
+     * @param deltas The deltas of the instruction, oldest first.
+     * @param numDeltas The number of deltas.
+     * @param predictedDelta Pointer to store the delta that followed the pair.
+     * @return True if the pair was found.
+     */
+    bool correlateDeltas(const Delta* deltas, int numDeltas, Delta* predictedDelta) {
+        if (numDeltas < 3)
+            return false;
+
+        Delta lastDelta = deltas[numDeltas - 1], previousDelta = deltas[numDeltas - 2];
+        for (int i = numDeltas - 2; i >= 1; i--) {
+            if (deltas[i] == lastDelta && deltas[i - 1] == previousDelta) {
+                *predictedDelta = deltas[i + 1];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Gather the deltas of the probed instruction by following its links in the global history buffer.
+     * @return The number of deltas gathered into deltasBuffer.
+     */
+    int gatherHistoryBufferDeltas() {
+        int numDeltasGathered = 0;
+        Delta position = this->tableEntry->peekHistory()[0];
+        if (!isInHistoryBuffer(position))
+            return 0;
+
+        // The deltas are gathered newest first from the end of the buffer:
+        T newerAccess = this->historyBuffer[position & this->historyBufferMask].access;
+        position = this->historyBuffer[position & this->historyBufferMask].link;
+        while (numDeltasGathered < this->numDeltas && isInHistoryBuffer(position)) {
+            const HistoryBufferEntry& entry = this->historyBuffer[position & this->historyBufferMask];
+            this->deltasBuffer[this->numDeltas - 1 - numDeltasGathered] = newerAccess - entry.access;
+            newerAccess = entry.access;
+            position = entry.link;
+            numDeltasGathered++;
+        }
+        return numDeltasGathered;
+    }
+
+public:
+    long numHits = 0; /**< Number of hits during simulation. */
+    double hitRate = 0.0; /**< The hit rate during simulation. */
+
+    shared_ptr<HistoryCache<T, T, Delta, T>> instructionTable; /**< The instruction table (history: deltas or GHB pointer). */
+    vector<HistoryBufferEntry> historyBuffer; /**< The global history buffer (ring, empty for DCPT). */
+    Delta historyBufferHead = 0; /**< Position of the next access to insert in the global history buffer. */
+    Delta historyBufferMask = 0; /**< Mask that maps a position to its slot of the global history buffer. */
+
+    HistoryCacheType historyCacheType; /**< Type of history cache (Infinite or Real). */
+    CacheParameters tableCacheParams = {}; /**< Cache parameters for the instruction table (numSequenceAccesses = number of deltas). */
+    int historyBufferNumIndexBits = 0; /**< Number of index bits of the global history buffer. */
+
+    bool isGlobalHistoryBuffer = false; /**< Whether the deltas are kept in a global history buffer (GHB) or in the table (DCPT). */
+    int numDeltas = 0; /**< Number of deltas correlated per instruction. */
+
+    bool countMemoryCapacity = false; /**< Flag to determine if memory costs are calculated. */
+    shared_ptr<PrefetchCacheSimulator<T>> prefetchSimulator = nullptr; /**< Data caches fed with the predictions as prefetches (nullptr if not simulated). */
+
+    /**
+     * @brief Constructor for initializing the model with the cache parameters of its structures.
+     *
+     * @param historyCacheType The type of the history cache (Infinite or Real).
+     * @param tableCacheParams Parameters for the instruction table; numSequenceAccesses is the number of deltas.
+     * @param historyBufferCacheParams Parameters for the global history buffer (only numIndexBits, used by GHB).
+     * @param isGlobalHistoryBuffer Whether the predictor is a GHB instead of a DCPT.
+     * @param countTotalMemoryCost Flag to count memory costs or not.
+     */
+    CorrelationPredictor(HistoryCacheType historyCacheType, CacheParameters tableCacheParams = {},
+        CacheParameters historyBufferCacheParams = {}, bool isGlobalHistoryBuffer = false, bool countTotalMemoryCost = true) {
+        this->historyCacheType = historyCacheType;
+        this->tableCacheParams = tableCacheParams;
+        this->historyBufferNumIndexBits = historyBufferCacheParams.numIndexBits;
+        this->isGlobalHistoryBuffer = isGlobalHistoryBuffer;
+        initializePredictor();
+        this->countMemoryCapacity = !countTotalMemoryCost;
+    }
+
+    /**
+     * @brief Destructor for cleaning up resources.
+     */
+    ~CorrelationPredictor() {
+        clean();
+    }
+
+    /**
+     * @brief Clean up resources and reset state.
+     */
+    void clean() {
+        this->instructionTable->clean();
+        this->data = {};
+        this->isProbeValid = false;
+    }
+
+    /**
+     * @brief Import a new access dataset.
+     *
+     * @param data The access dataset to import.
+     * @param datasetClases The dataset of classes (not used in this function).
+     */
+    void importData(AccessesDataset<T, T>& data, BuffersDataset<int>& datasetClases) {
+        this->data = data;
+    }
+
+    /**
+     * @brief Write the state of the instruction table and the global history buffer into a binary snapshot.
+     *
+     * @param os Output stream of the snapshot.
+     */
+    void save(ostream& os) {
+        this->instructionTable->save(os);
+        writeBinaryVector(os, this->historyBuffer);
+        writeBinary(os, this->historyBufferHead);
+    }
+
+    /**
+     * @brief Restore the state of the instruction table and the global history buffer from a binary snapshot.
+     *
+     * @param is Input stream of the snapshot.
+     */
+    void load(istream& is) {
+        this->instructionTable->load(is);
+        readBinaryVector(is, this->historyBuffer);
+        readBinary(is, this->historyBufferHead);
+        this->isProbeValid = false;
+    }
+
+    /**
+     * @brief Initialize the instruction table and the global history buffer.
+     */
+    void initializePredictor() {
+        this->numDeltas = this->tableCacheParams.numSequenceAccesses;
+        if (this->numDeltas < 3) {
+            string msg = "ERROR: The correlation predictors need at least 3 deltas per instruction (numSequenceAccesses)\n";
+            std::cout << msg;
+            throw std::invalid_argument(msg);
+        }
+        if (this->isGlobalHistoryBuffer && (this->historyBufferNumIndexBits <= 0 || this->historyBufferNumIndexBits > 30)) {
+            string msg = "ERROR: The global history buffer needs between 1 and 30 index bits (additionalCacheParams)\n";
+            std::cout << msg;
+            throw std::invalid_argument(msg);
+        }
+
+        // DCPT keeps the deltas (and how many of them are valid) in the table, while GHB only keeps the position of the last access:
+        int historyLength = this->isGlobalHistoryBuffer ? 1 : this->numDeltas + 1;
+        if (historyCacheType == HistoryCacheType::Infinite) {
+            this->instructionTable = shared_ptr<HistoryCache<T, T, Delta, T>>(
+                new InfiniteHistoryCache<T, T, Delta, T>(historyLength, 1));
+        }
+        else if (historyCacheType == HistoryCacheType::Real) {
+            this->instructionTable = shared_ptr<HistoryCache<T, T, Delta, T>>(
+                new RealHistoryCache<T, T, Delta, T>(
+                    this->tableCacheParams.numIndexBits,
+                    this->tableCacheParams.numWays, historyLength, 1));
+        }
+        else {
+            this->instructionTable = nullptr;
+        }
+
+        if (this->instructionTable != nullptr)
+            this->instructionTable->setNumBitsPerClass(this->isGlobalHistoryBuffer ?
+                this->historyBufferNumIndexBits : (int)(sizeof(Delta) * 8));
+
+        if (this->isGlobalHistoryBuffer) {
+            this->historyBuffer = vector<HistoryBufferEntry>((size_t)1 << this->historyBufferNumIndexBits);
+            this->historyBufferMask = (Delta)this->historyBuffer.size() - 1;
+            this->deltasBuffer = vector<Delta>(this->numDeltas);
+        }
+        else {
+            this->historyBuffer = vector<HistoryBufferEntry>();
+            this->historyBufferMask = 0;
+        }
+        this->historyBufferHead = 0;
+        this->isProbeValid = false;
+    }
+
+    /**
+     * @brief Train the predictor with an instruction and its access.
+     *
+     * @param instruction The instruction to train on.
+     * @param access The access value associated with the instruction.
+     */
+    void fit(T instruction, T access) {
+        // The slot found by the prediction of this access is reused, unless the table was not probed for it:
+        if (!this->isProbeValid || this->probedInstruction != instruction)
+            probeTable(instruction);
+        this->isProbeValid = false;
+
+        if (this->isGlobalHistoryBuffer) {
+            Delta position = this->historyBufferHead++;
+            Delta link = this->tableEntry != nullptr ? this->tableEntry->peekHistory()[0] : -1;
+            this->historyBuffer[position & this->historyBufferMask] = { access, link };
+            this->instructionTable->updateEntry(instruction, this->tableEntry, access, position);
+        }
+        else if (this->tableEntry != nullptr) {
+            // The new delta is shifted into the history (over the number of valid deltas), which is written after it:
+            Delta numValidDeltas = min(this->tableEntry->peekHistory()[this->numDeltas] + 1, (Delta)this->numDeltas);
+            Delta delta = access - this->tableEntry->getLastAccess();
+            this->instructionTable->updateEntry(instruction, this->tableEntry, access, delta);
+            this->tableEntry->setHistoryValue(this->numDeltas - 1, delta);
+            this->tableEntry->setHistoryValue(this->numDeltas, numValidDeltas);
+        }
+        else {
+            // A new entry may reuse the slot of an evicted instruction, so its deltas are cleared and none is valid:
+            this->instructionTable->updateEntry(instruction, nullptr, access, 0);
+            auto entry = this->instructionTable->findEntry(instruction);
+            for (int i = 0; i <= this->numDeltas; i++)
+                entry->setHistoryValue(i, 0);
+        }
+    }
+
+    /**
+     * @brief Predict the access for a given instruction.
+     *
+     * @param instruction The instruction to predict for.
+     * @param access Pointer to store the predicted access value.
+     * @param instrIsInTable Pointer to indicate if the instruction is in the instruction table.
+     * @return True if a prediction is issued, false otherwise.
+     */
+    bool predict(T instruction, T* access, bool* instrIsInTable) {
+        probeTable(instruction);
+        *instrIsInTable = this->tableEntry != nullptr;
+        if (!(*instrIsInTable))
+            return false;
+
+        Delta predictedDelta;
+        bool isCorrelated;
+        if (this->isGlobalHistoryBuffer) {
+            int numDeltasGathered = gatherHistoryBufferDeltas();
+            isCorrelated = correlateDeltas(this->deltasBuffer.data() + this->numDeltas - numDeltasGathered,
+                numDeltasGathered, &predictedDelta);
+        }
+        else {
+            const vector<Delta>& history = this->tableEntry->peekHistory();
+            int numValidDeltas = (int)history[this->numDeltas];
+            isCorrelated = correlateDeltas(history.data() + this->numDeltas - numValidDeltas, numValidDeltas, &predictedDelta);
+        }
+        if (!isCorrelated)
+            return false;
+
+        *access = this->tableEntry->getLastAccess() + predictedDelta;
+        return true;
+    }
+
+    /**
+     * @brief Simplified prediction method.
+     *
+     * @param instruction The instruction to predict for.
+     * @param access Pointer to store the predicted access value.
+     * @return True if a prediction is issued, false otherwise.
+     */
+    bool predict(T instruction, T* access) {
+        bool dummyInstr;
+        return predict(instruction, access, &dummyInstr);
+    }
+
+    /**
+     * @brief Simulate the predictor on the dataset.
+     *
+     * @param initialize Whether to initialize the predictor before simulation.
+     * @return Shared pointer to a structure containing prediction results and costs.
+     */
+    shared_ptr<PredictResultsAndCosts> simulate(bool initialize = true) {
+        CorrelationPredictResultsAndCosts resultsAndCosts;
+        double numTableMisses = 0.0;
+        double numPredictions = 0.0;
+
+        if (initialize) {
+            this->initializePredictor();
+        }
+        if (this->prefetchSimulator != nullptr) {
+            if (initialize) this->prefetchSimulator->reset();
+            else this->prefetchSimulator->resetCounters();
+        }
+
+        numHits = 0;
+        hitRate = 0.0;
+
+        for (int i = 0; i < data.accesses.size(); i++) {
+            T input = data.accessesInstructions[i];
+            T output = data.accesses[i];
+            T predictedOutput = 0;
+            bool instrIsInTable;
+            bool isPredicted = predict(input, &predictedOutput, &instrIsInTable);
+
+            if (!instrIsInTable) numTableMisses++;
+            if (isPredicted) {
+                numPredictions++;
+                if (output == predictedOutput) numHits++;
+            }
+
+            fit(input, output);
+
+            // Once trained with this access, the next access of the instruction is predicted and prefetched:
+            if (this->prefetchSimulator != nullptr) {
+                this->prefetchSimulator->access(output);
+                T prefetchedOutput;
+                if (predict(input, &prefetchedOutput))
+                    this->prefetchSimulator->prefetch(prefetchedOutput);
+            }
+
+            if (i % numPartsToPrint == 0) {
+                std::cout << input << " -> " << output << " vs " << predictedOutput << std::endl;
+                std::cout << "Hit rate: " << static_cast<double>(numHits) / (i + 1)
+                    << " ; " << static_cast<double>(i) / data.accesses.size() << std::endl;
+            }
+        }
+
+        hitRate = static_cast<double>(numHits) / data.accesses.size();
+
+        resultsAndCosts.hitRate = hitRate;
+        resultsAndCosts.coverage = numPredictions / data.accesses.size();
+        resultsAndCosts.accuracy = numPredictions > 0 ? numHits / numPredictions : 0.0;
+        resultsAndCosts.tableMissRate = numTableMisses / data.accesses.size();
+        resultsAndCosts.tableMemoryCost = getTableMemoryCost(!this->countMemoryCapacity);
+        resultsAndCosts.historyBufferMemoryCost = getHistoryBufferMemoryCost();
+        resultsAndCosts.totalMemoryCost = resultsAndCosts.tableMemoryCost + resultsAndCosts.historyBufferMemoryCost;
+        if (this->prefetchSimulator != nullptr)
+            resultsAndCosts.prefetch = this->prefetchSimulator->getResults();
+        return shared_ptr<PredictResultsAndCosts>((PredictResultsAndCosts*)
+            new CorrelationPredictResultsAndCosts(resultsAndCosts));
+    }
+
+    /**
+     * @brief Calculate the memory cost of the instruction table.
+     *
+     * The number of valid deltas of a DCPT entry takes a whole delta in its history, but only needs the bits to count
+     * up to the number of deltas, so only these are costed.
+     *
+     * @param countTags Whether the tag and LRU bits are counted.
+     * @return Memory cost in bytes.
+     */
+    double getTableMemoryCost(bool countTags) {
+        double cost = countTags ? this->instructionTable->getTotalMemoryCost() : this->instructionTable->getMemoryCost();
+        if (!this->isGlobalHistoryBuffer) {
+            double numCounterBits = ceil(log2(this->numDeltas + 1));
+            cost -= this->instructionTable->getNumEntries() * (sizeof(Delta) * 8.0 - numCounterBits) / 8.0;
+        }
+        return cost;
+    }
+
+    /**
+     * @brief Calculate the memory cost of the global history buffer (an access and a link per entry).
+     *
+     * @return Memory cost in bytes.
+     */
+    double getHistoryBufferMemoryCost() {
+        return this->historyBuffer.size() * (sizeof(T) * 8.0 + this->historyBufferNumIndexBits) / 8.0;
+    }
+
+    /**
+     * @brief Calculate the total memory cost, including tags and LRU bits.
+     *
+     * @return Total memory cost in bytes.
+     */
+    double getTotalMemoryCost() {
+        return getTableMemoryCost(true) + getHistoryBufferMemoryCost();
+    }
+
+    /**
+     * @brief Calculate the memory cost, excluding tags and LRU bits.
+     *
+     * @return Memory cost in bytes.
+     */
+    double getMemoryCost() {
+        return getTableMemoryCost(false) + getHistoryBufferMemoryCost();
+    }
+};
@@ -28,93 +28,185 @@
 //#include "Experimentation.h"
 #include "Global.h"
 #include "PredictorModel.h"
+#include "PrefetchCacheSimulator.h"
 
 using namespace std;
 
 /**
- * @brief HashOnHashDFCM Class that implements a prediction model using hash-based history tables.
+ * @brief Hash policy of the hash-on-hash DFCM.
  *
- * This class models a prediction system based on two-level history caches: one for instructions and another for deltas.
- * It is used to simulate and predict access patterns for given data based on previous access histories.
+ * The first table keeps a single hash of the whole delta history of each instruction, and every new delta is xored
+ * into it.
+ *
+ * A hash policy of DFCMPredictor tells whether the first table also keeps the last deltas (keepsDeltas), how many of
+ * them (getOrder), and how a new delta enters the hash (nextHash). The policies that keep the deltas also hash a
+ * history from scratch (computeHash).
+ *
+ * @tparam T Type of instruction and access data.
+ */
+template<typename T>
+struct HashOnHashPolicy {
+    static constexpr bool keepsDeltas = false; /**< Whether the first table keeps the deltas of the histories besides their hash. */
+
+    /**
+     * @brief Configure the policy from the parameters of the predictor (the hash-on-hash has none).
+     *
+     * @param firstTableCacheParams Parameters for the first table cache.
+     * @param secondTableCacheParams Parameters for the second table cache.
+     * @param hashType Hash function of the delta histories.
+     */
+    void configure(CacheParameters /*firstTableCacheParams*/, CacheParameters /*secondTableCacheParams*/, DFCMHashType /*hashType*/) {}
+
+    /**
+     * @brief Get the number of deltas kept before the hash in the history of the first table.
+     * @return The order (0: only the hash is kept).
+     */
+    int getOrder() const { return 0; }
+
+    /**
+     * @brief Fold a new delta into the hash of a history.
+     *
+     * @param hash The hash of the current history.
+     * @param oldestDelta The oldest delta of the current history (not used).
+     * @param newDelta The new delta.
+     * @return The hash of the next history.
+     */
+    T nextHash(T hash, T /*oldestDelta*/, T newDelta) const { return hash ^ newDelta; }
+};
+
+/**
+ * @brief DFCMPredictor Class that implements the two-level DFCM predictors, with the hashing of the delta histories
+ * given by a policy.
+ *
+ * The first table keeps, for each instruction, its last access and a history whose last element is the hash of its
+ * deltas (preceded by the last K deltas if the policy keeps them). The second table keeps the delta that followed each
+ * hash. The hash policy is a template parameter, so the hot loop of every variant (HashOnHashDFCM, KOrderDFCM) is the
+ * same code, with the hashing inlined and the branches on the variant resolved at compile time.
  *
  * @tparam T Type of instruction and access data.
  * @tparam Delta Type representing the delta between two accesses.
+ * @tparam HashPolicy Hash policy of the delta histories (e.g. HashOnHashPolicy).
  */
-template<typename T, typename Delta>
-class HashOnHashDFCM : public PredictorModel<T, int> {
+template<typename T, typename Delta, typename HashPolicy>
+class DFCMPredictor : public PredictorModel<T, int> {
 protected:
     int numPartsToPrint = 10000; /**< Number of parts to print during simulation for progress tracking. */
     AccessesDataset<T, T> data; /**< The dataset of accesses. */
+    HashPolicy hashPolicy; /**< Hash policy of the delta histories, configured by initializePredictor. */
+
+    HistoryCacheEntry<T, T, T>* firstTableEntry = nullptr; /**< Entry of the last probed instruction in the first table (nullptr if missing). */
+    HistoryCacheEntry<T, T, Delta>* secondTableEntry = nullptr; /**< Entry of its hash in the second table (nullptr if missing). */
+    T probedInstruction = 0; /**< Instruction of the last probe. */
+    bool isProbeValid = false; /**< Whether the entries of the last probe still point to the current table slots. */
 
     /**
-     * @brief Access the instruction hash table.
+     * @brief Probe both tables for an instruction, keeping references to the slots found.
      *
-     * @param instruction The instruction to look up in the hash table.
-     * @param entry Pointer to the entry to be filled if found.
-     * @return True if the entry is found, false otherwise.
+     * predict and fit of the same access share this probe, and the tables are updated in place
+     * through the references, so no entry is copied or allocated per access.
+     *
+     * @param instruction The instruction to look up.
      */
-    bool accessInstrHashTable(T instruction, shared_ptr<HistoryCacheEntry<T, T, T>>* entry) {
-        shared_ptr<HistoryCacheEntry<T, T, T>> firstTableEntry =
-            shared_ptr<HistoryCacheEntry<T, T, T>>(new StandardHistoryCacheEntry<T, T, T>());
-        bool entryIsFound = this->instrHashTable->getEntry(instruction, firstTableEntry.get());
-        if (!entryIsFound) {
-            return false;
-        }
-        else {
-            *entry = firstTableEntry;
-            return true;
+    void probeTables(T instruction) {
+        this->firstTableEntry = this->instrHashTable->findEntry(instruction);
+        this->secondTableEntry = nullptr;
+        if (this->firstTableEntry != nullptr) {
+            T hash = this->firstTableEntry->peekHistory()[this->hashPolicy.getOrder()];
+            this->secondTableEntry = this->hashDeltaTable->findEntry(hash);
         }
+        this->probedInstruction = instruction;
+        this->isProbeValid = true;
     }
 
     /**
-     * @brief Access the hash delta table.
-     *
-     * @param hash The hash to look up in the hash delta table.
-     * @param entry Pointer to the entry to be filled if found.
-     * @return True if the entry is found, false otherwise.
+     * @brief Get the maximum value of the confidence counters of the second table.
+     * @return The maximum confidence.
      */
-    bool accessHashDeltaTable(T hash, shared_ptr<HistoryCacheEntry<T, T, Delta>>* entry) {
-        shared_ptr<HistoryCacheEntry<T, T, Delta>> secondTableEntry =
-            shared_ptr<HistoryCacheEntry<T, T, Delta>>(new StandardHistoryCacheEntry<T, T, Delta>());
-        bool entryIsFound = this->hashDeltaTable->getEntry(hash, secondTableEntry.get());
-        if (!entryIsFound) {
-            return false;
-        }
-        else {
-            *entry = secondTableEntry;
-            return true;
-        }
+    T getMaxConfidence() {
+        return ((T)1 << this->numConfidenceBits) - 1;
+    }
+
+    /**
+     * @brief Whether the delta of a second table entry is confident enough to be predicted.
+     * @param entry The entry of the second table.
+     * @return True if there are no confidence counters, or if the counter of the entry reaches the threshold.
+     */
+    bool isConfident(HistoryCacheEntry<T, T, Delta>* entry) {
+        return this->numConfidenceBits == 0 || entry->peekHistory().back() >= this->confidenceThreshold;
     }
 
     /**
-     * @brief Write to the instruction hash table.
+     * @brief Update the delta that followed the probed hash in the second table.
+     *
+     * Without confidence counters, the delta is always replaced. Otherwise the counter of the entry, kept in its
+     * history (the slot next to the delta, which every update already writes), saturates up while the same delta
+     * is seen, and the stored delta is only replaced once its confidence is exhausted, so a single noisy delta does
+     * not evict a stable one.
      *
-     * @param instruction The instruction to write to the hash table.
-     * @param lastAccess The last access time.
-     * @param hash The hash value to be written.
-     * @return True if the instruction was already in the table, false otherwise.
+     * @param hash The hash of the history of deltas.
+     * @param delta The delta that followed it.
      */
-    bool writeInstrHashTable(T instruction, T lastAccess, T hash) {
-        shared_ptr<HistoryCacheEntry<T, T, T>> firstTableEntry =
-            shared_ptr<HistoryCacheEntry<T, T, T>>(new StandardHistoryCacheEntry<T, T, T>());
-        bool wasInTable = accessInstrHashTable(instruction, &firstTableEntry);
-        this->instrHashTable->newAccess(instruction, lastAccess, hash);
-        return wasInTable;
+    void updateSecondTable(T hash, Delta delta) {
+        if (this->numConfidenceBits == 0 || this->secondTableEntry == nullptr) {
+            this->hashDeltaTable->updateEntry(hash, this->secondTableEntry, delta, 0);
+            return;
+        }
+
+        Delta storedDelta = this->secondTableEntry->getLastAccess();
+        T confidence = this->secondTableEntry->peekHistory().back();
+        if (delta == storedDelta) {
+            confidence = min(confidence + 1, getMaxConfidence());
+        }
+        else {
+            if (confidence > 0)
+                confidence--;
+            if (confidence == 0)
+                storedDelta = delta;
+        }
+        this->hashDeltaTable->updateEntry(hash, this->secondTableEntry, storedDelta, confidence);
     }
 
+    vector<T> lookaheadAccesses; /**< Accesses chained by the last call to predictAhead, from depth 1 on. */
+    vector<T> lookaheadDeltas; /**< Deltas of the probed history followed by the chained ones (if the policy keeps them). */
+
     /**
-     * @brief Write to the hash delta table.
+     * @brief Chain the predictions of the probed instruction up to the prediction degree, without updating the tables.
+     *
+     * Each predicted delta enters the hash, as fit would do, to look up the delta of the next depth.
      *
-     * @param hash The hash to write to the delta table.
-     * @param delta The delta value to be written.
-     * @return True if the hash was already in the table, false otherwise.
+     * @return The number of accesses chained into lookaheadAccesses (0 if the next access is not predicted).
      */
-    bool writeHashDeltaTable(T hash, Delta delta) {
-        shared_ptr<HistoryCacheEntry<T, T, Delta>> secondTableEntry =
-            shared_ptr<HistoryCacheEntry<T, T, Delta>>(new StandardHistoryCacheEntry<T, T, Delta>());
-        bool wasInTable = accessHashDeltaTable(hash, &secondTableEntry);
-        this->hashDeltaTable->newAccess(hash, delta, 0);
-        return wasInTable;
+    int predictAhead() {
+        if (this->firstTableEntry == nullptr || this->secondTableEntry == nullptr)
+            return 0;
+
+        // The chain stops at the first delta that is not confident enough to be predicted:
+        int order = this->hashPolicy.getOrder();
+        const vector<T>& history = this->firstTableEntry->peekHistory();
+        this->lookaheadAccesses.resize(this->predictionDegree);
+        if constexpr (HashPolicy::keepsDeltas)
+            this->lookaheadDeltas.assign(history.begin(), history.begin() + order);
+
+        T access = this->firstTableEntry->getLastAccess();
+        T hash = history[order];
+        auto entry = this->secondTableEntry;
+        int numPredicted = 0;
+        while (entry != nullptr && isConfident(entry)) {
+            Delta delta = entry->getLastAccess();
+            access = access + delta;
+            this->lookaheadAccesses[numPredicted++] = access;
+            if (numPredicted == this->predictionDegree)
+                break;
+            if constexpr (HashPolicy::keepsDeltas) {
+                hash = this->hashPolicy.nextHash(hash, this->lookaheadDeltas[numPredicted - 1], (T)delta);
+                this->lookaheadDeltas.push_back((T)delta);
+            }
+            else {
+                hash = this->hashPolicy.nextHash(hash, 0, (T)delta);
+            }
+            entry = this->hashDeltaTable->findEntry(hash);
+        }
+        return numPredicted;
     }
 
 public:
@@ -125,10 +217,15 @@ public:
     shared_ptr<HistoryCache<T, T, T, Delta>> hashDeltaTable; /**< The hash delta table. */
 
     HistoryCacheType historyCacheType; /**< Type of history cache (Infinite or Real). */
-    CacheParameters firstTableCacheParams = {}; /**< Cache parameters for the first table. */
+    CacheParameters firstTableCacheParams = {}; /**< Cache parameters for the first table (numSequenceAccesses is the order K of the K-order DFCM). */
     CacheParameters secondTableCacheParams = {}; /**< Cache parameters for the second table. */
 
     bool countMemoryCapacity = false; /**< Flag to determine if memory costs are calculated. */
+    int predictionDegree = 1; /**< Number of accesses of each instruction predicted ahead (1: only the next one). */
+    shared_ptr<PrefetchCacheSimulator<T>> prefetchSimulator = nullptr; /**< Data caches fed with the predictions as prefetches (nullptr if not simulated). */
+    DFCMHashType hashType = DFCMHashType::XorFold; /**< Hash function of the delta histories (K-order DFCM). */
+    int numConfidenceBits = 0; /**< Bits of the saturating confidence counter of each second table entry (0: no counters, see setConfidence). */
+    T confidenceThreshold = 1; /**< Minimum confidence of a delta to be predicted (if there are confidence counters). */
 
     /**
      * @brief Constructor for initializing the model with data and cache parameters.
@@ -138,14 +235,16 @@ public:
      * @param firstTableCacheParams Parameters for the first table cache.
      * @param secondTableCacheParams Parameters for the second table cache.
      * @param countTotalMemoryCost Flag to count memory costs or not.
+     * @param hashType Hash function of the delta histories (K-order DFCM).
      */
-    HashOnHashDFCM(AccessesDataset<T, T>& data, HistoryCacheType historyCacheType,
+    DFCMPredictor(AccessesDataset<T, T>& data, HistoryCacheType historyCacheType,
         CacheParameters firstTableCacheParams = {}, CacheParameters secondTableCacheParams = {},
-        bool countTotalMemoryCost = true) {
+        bool countTotalMemoryCost = true, DFCMHashType hashType = DFCMHashType::XorFold) {
         this->data = data;
         this->historyCacheType = historyCacheType;
         this->firstTableCacheParams = firstTableCacheParams;
         this->secondTableCacheParams = secondTableCacheParams;
+        this->hashType = hashType;
         initializePredictor();
         this->countMemoryCapacity = !countTotalMemoryCost;
     }
@@ -157,12 +256,15 @@ public:
      * @param firstTableCacheParams Parameters for the first table cache.
      * @param secondTableCacheParams Parameters for the second table cache.
      * @param countTotalMemoryCost Flag to count memory costs or not.
+     * @param hashType Hash function of the delta histories (K-order DFCM).
      */
-    HashOnHashDFCM(HistoryCacheType historyCacheType, CacheParameters firstTableCacheParams = {},
-        CacheParameters secondTableCacheParams = {}, bool countTotalMemoryCost = true) {
+    DFCMPredictor(HistoryCacheType historyCacheType, CacheParameters firstTableCacheParams = {},
+        CacheParameters secondTableCacheParams = {}, bool countTotalMemoryCost = true,
+        DFCMHashType hashType = DFCMHashType::XorFold) {
         this->historyCacheType = historyCacheType;
         this->firstTableCacheParams = firstTableCacheParams;
         this->secondTableCacheParams = secondTableCacheParams;
+        this->hashType = hashType;
         initializePredictor();
         this->countMemoryCapacity = !countTotalMemoryCost;
     }
@@ -170,7 +272,7 @@ public:
     /**
      * @brief Destructor for cleaning up resources.
      */
-    ~HashOnHashDFCM() {
+    ~DFCMPredictor() {
         clean();
     }
 
@@ -183,6 +285,7 @@ public:
         this->instrHashTable->clean();
         this->hashDeltaTable->clean();
         this->data = {};
+        this->isProbeValid = false;
     }
 
     /**
@@ -196,15 +299,52 @@ public:
     }
 
     /**
- * @brief Initialize the predictor based on the history cache type.
- *
- * Sets up the instruction hash table and hash delta table according to the
- * specified cache type (Infinite or Real) and parameters.
- */
+     * @brief Write the state of both tables into a binary snapshot.
+     *
+     * @param os Output stream of the snapshot.
+     */
+    void save(ostream& os) {
+        this->instrHashTable->save(os);
+        this->hashDeltaTable->save(os);
+    }
+
+    /**
+     * @brief Restore the state of both tables from a binary snapshot written by save.
+     *
+     * @param is Input stream of the snapshot.
+     */
+    void load(istream& is) {
+        this->instrHashTable->load(is);
+        this->hashDeltaTable->load(is);
+        this->isProbeValid = false;
+    }
+
+    /**
+     * @brief Set the confidence counters of the second table (see updateSecondTable).
+     *
+     * @param numConfidenceBits Bits of the saturating counter of each entry (0: no counters, the delta is always replaced).
+     * @param confidenceThreshold Minimum confidence of a delta to be predicted.
+     */
+    void setConfidence(int numConfidenceBits, int confidenceThreshold) {
+        this->numConfidenceBits = numConfidenceBits;
+        this->confidenceThreshold = (T)confidenceThreshold;
+        if (this->hashDeltaTable != nullptr)
+            this->hashDeltaTable->setNumBitsPerClass(numConfidenceBits);
+    }
+
+    /**
+     * @brief Initialize the predictor based on the history cache type.
+     *
+     * Configures the hash policy and sets up the instruction hash table and hash delta table according to the
+     * specified cache type (Infinite or Real) and parameters.
+     */
     void initializePredictor() {
+        this->hashPolicy.configure(this->firstTableCacheParams, this->secondTableCacheParams, this->hashType);
+        int historyLength = this->hashPolicy.getOrder() + 1;
+
         if (historyCacheType == HistoryCacheType::Infinite) {
             this->instrHashTable = shared_ptr<HistoryCache<T, T, T, T>>(
-                new InfiniteHistoryCache<T, T, T, T>(1, 1));
+                new InfiniteHistoryCache<T, T, T, T>(historyLength, 1));
 
             this->hashDeltaTable = shared_ptr<HistoryCache<T, T, T, Delta>>(
                 new InfiniteHistoryCache<T, T, T, Delta>(1, 1));
@@ -213,7 +353,7 @@ public:
             this->instrHashTable = shared_ptr<HistoryCache<T, T, T, T>>(
                 new RealHistoryCache<T, T, T, T>(
                     this->firstTableCacheParams.numIndexBits,
-                    this->firstTableCacheParams.numWays, 1, 1));
+                    this->firstTableCacheParams.numWays, historyLength, 1));
 
             this->hashDeltaTable = shared_ptr<HistoryCache<T, T, T, Delta>>(
                 new RealHistoryCache<T, T, T, Delta>(
@@ -224,6 +364,14 @@ public:
             this->instrHashTable = nullptr;
             this->hashDeltaTable = nullptr;
         }
+
+        // The history of the first table keeps the deltas (if any) and their hash, and the delta of the second one is its last access,
+        // with the confidence counter (if any) as its history:
+        if (this->instrHashTable != nullptr) {
+            this->instrHashTable->setNumBitsPerClass(sizeof(T) * 8);
+            this->hashDeltaTable->setNumBitsPerClass(this->numConfidenceBits);
+        }
+        this->isProbeValid = false;
     }
 
     /**
@@ -236,26 +384,40 @@ public:
      * @param access The access value associated with the instruction.
      */
     void fit(T instruction, T access) {
-        shared_ptr<HistoryCacheEntry<T, T, T>> firstTableEntry =
-            shared_ptr<HistoryCacheEntry<T, T, T>>(
-                new StandardHistoryCacheEntry<T, T, T>());
-
-        T hash;
-        T lastAccess;
-        Delta delta;
-        bool hashIsInTable = accessInstrHashTable(instruction, &firstTableEntry);
-        if (!hashIsInTable) {
-            hash = 0;
-            delta = 0;
-            this->writeInstrHashTable(instruction, access, hash);
+        // The slots found by the prediction of this access are reused, unless the tables were not probed for it:
+        if (!this->isProbeValid || this->probedInstruction != instruction)
+            probeTables(instruction);
+        this->isProbeValid = false;
+
+        int order = this->hashPolicy.getOrder();
+        if (this->firstTableEntry == nullptr) {
+            this->instrHashTable->updateEntry(instruction, nullptr, access, 0);
+            if constexpr (HashPolicy::keepsDeltas) {
+                // The empty history (hash 0) is followed by a zero delta, with the same confidence update as any other:
+                this->secondTableEntry = this->hashDeltaTable->findEntry(0);
+                updateSecondTable(0, 0);
+
+                // The history of a new entry is hashed from scratch:
+                auto entry = this->instrHashTable->findEntry(instruction);
+                entry->setHistoryValue(order - 1, 0);
+                entry->setHistoryValue(order, this->hashPolicy.computeHash(entry->peekHistory()));
+            }
         }
         else {
-            lastAccess = firstTableEntry->getLastAccess();
-            hash = firstTableEntry->getHistory()[0];
-            delta = access - lastAccess;
-            this->writeHashDeltaTable(hash, delta);
-            hash = hash ^ static_cast<T>(delta);
-            this->writeInstrHashTable(instruction, access, hash);
+            const vector<T>& history = this->firstTableEntry->peekHistory();
+            Delta delta = access - this->firstTableEntry->getLastAccess();
+            T hash = history[order];
+            T nextHash = this->hashPolicy.nextHash(hash, history[0], (T)delta);
+            updateSecondTable(hash, delta);
+            if constexpr (HashPolicy::keepsDeltas) {
+                // The new delta is shifted into the history (over the hash), and the hash is written after it:
+                this->instrHashTable->updateEntry(instruction, this->firstTableEntry, access, (T)delta);
+                this->firstTableEntry->setHistoryValue(order - 1, (T)delta);
+                this->firstTableEntry->setHistoryValue(order, nextHash);
+            }
+            else {
+                this->instrHashTable->updateEntry(instruction, this->firstTableEntry, access, nextHash);
+            }
         }
     }
 
@@ -269,38 +431,17 @@ public:
      * @param access Pointer to store the predicted access value.
      * @param instrIsInTable Pointer to indicate if the instruction is in the hash table.
      * @param hashIsInTable Pointer to indicate if the hash is in the hash delta table.
-     * @return True if the prediction is successful, false otherwise.
+     * @return True if the prediction is successful (and confident enough), false otherwise.
      */
     bool predict(T instruction, T* access, bool* instrIsInTable, bool* hashIsInTable) {
-        T hash;
-        T lastAccess;
-        *instrIsInTable = false;
-        *hashIsInTable = false;
-
-        shared_ptr<HistoryCacheEntry<T, T, T>> firstTableEntry =
-            shared_ptr<HistoryCacheEntry<T, T, T>>(
-                new StandardHistoryCacheEntry<T, T, T>());
-        shared_ptr<HistoryCacheEntry<T, T, Delta>> secondTableEntry =
-            shared_ptr<HistoryCacheEntry<T, T, Delta>>(
-                new StandardHistoryCacheEntry<T, T, Delta>());
-
-        *instrIsInTable = accessInstrHashTable(instruction, &firstTableEntry);
-
-        if (!(*instrIsInTable)) {
+        probeTables(instruction);
+        *instrIsInTable = this->firstTableEntry != nullptr;
+        *hashIsInTable = this->secondTableEntry != nullptr;
+        if (!(*instrIsInTable) || !(*hashIsInTable) || !isConfident(this->secondTableEntry))
             return false;
-        }
-        else {
-            lastAccess = firstTableEntry->getLastAccess();
-            hash = firstTableEntry->getHistory()[0];
-            *hashIsInTable = accessHashDeltaTable(hash, &secondTableEntry);
-            if (!(*hashIsInTable)) {
-                return false;
-            }
-            else {
-                Delta delta = secondTableEntry->getLastAccess();
-                *access = lastAccess + delta;
-            }
-        }
+
+        Delta delta = this->secondTableEntry->getLastAccess();
+        *access = this->firstTableEntry->getLastAccess() + delta;
         return true;
     }
 
@@ -318,6 +459,20 @@ public:
         return predict(instruction, access, &dummyInstr, &dummyHash);
     }
 
+    /**
+     * @brief Prefetch the next accesses of an instruction, chained up to the prediction degree, without updating the
+     * tables.
+     *
+     * @param instruction The instruction, once the tables have been trained with its last access.
+     * @param prefetchSimulator The data caches that receive the prefetches.
+     */
+    void prefetchAhead(T instruction, PrefetchCacheSimulator<T>& prefetchSimulator) {
+        probeTables(instruction);
+        int numPrefetches = predictAhead();
+        for (int d = 0; d < numPrefetches; d++)
+            prefetchSimulator.prefetch(this->lookaheadAccesses[d]);
+    }
+
     /**
      * @brief Simulate the predictor on the dataset.
      *
@@ -331,14 +486,24 @@ public:
         DFCMPredictResultsAndCosts resultsAndCosts;
         double numFirstTableMisses = 0.0;
         double numSecondTableMisses = 0.0;
+        double numPredictions = 0.0;
 
         if (initialize) {
             this->initializePredictor();
         }
+        if (this->prefetchSimulator != nullptr) {
+            if (initialize) this->prefetchSimulator->reset();
+            else this->prefetchSimulator->resetCounters();
+        }
 
         numHits = 0;
         hitRate = 0.0;
 
+        // The predictions ahead are scored against the next accesses of each instruction:
+        bool isLookahead = this->predictionDegree > 1;
+        LookaheadCounters lookahead(isLookahead ? this->predictionDegree : 0);
+        vector<int> nextAccesses = isLookahead ? findNextInstructionAccesses(data.accessesInstructions) : vector<int>();
+
         for (int i = 0; i < data.accesses.size(); i++) {
             T input = data.accessesInstructions[i];
             T output = data.accesses[i];
@@ -358,9 +523,22 @@ public:
             else {
                 numHits++;
             }
+            if (!tableMiss)
+                numPredictions++;
+
+            if (isLookahead) {
+                int numPredicted = predictAhead();
+                lookahead.score(i, this->lookaheadAccesses.data(), numPredicted, data.accesses, nextAccesses);
+            }
 
             fit(input, output);
 
+            // Once trained with this access, the next accesses of the instruction are predicted and prefetched:
+            if (this->prefetchSimulator != nullptr) {
+                this->prefetchSimulator->access(output);
+                prefetchAhead(input, *this->prefetchSimulator);
+            }
+
             if (i % numPartsToPrint == 0) {
                 std::cout << input << " -> " << output << " vs " << predictedOutput << std::endl;
                 std::cout << "Hit rate: " << static_cast<double>(numHits) / (i + 1)
@@ -371,6 +549,8 @@ public:
         hitRate = static_cast<double>(numHits) / data.accesses.size();
 
         resultsAndCosts.hitRate = hitRate;
+        resultsAndCosts.coverage = numPredictions / data.accesses.size();
+        resultsAndCosts.accuracy = numPredictions > 0 ? numHits / numPredictions : 0.0;
         resultsAndCosts.firstTableMissRate = numFirstTableMisses / data.accesses.size();
         resultsAndCosts.secondTableMissRate = numSecondTableMisses / data.accesses.size();
         double firstTableCost, secondTableCost;
@@ -382,6 +562,9 @@ public:
         }
         resultsAndCosts.firstTableMemoryCost = firstTableCost;
         resultsAndCosts.secondTableMemoryCost = secondTableCost;
+        resultsAndCosts.lookahead = lookahead.getResults(data.accesses.size());
+        if (this->prefetchSimulator != nullptr)
+            resultsAndCosts.prefetch = this->prefetchSimulator->getResults();
         return shared_ptr<PredictResultsAndCosts>((PredictResultsAndCosts*)
             new DFCMPredictResultsAndCosts(resultsAndCosts));
     }
@@ -389,18 +572,17 @@ public:
     /**
      * @brief Calculate total memory costs including tags and LRU bits.
      *
+     * The costs are those of the tables (see RealHistoryCache::getTotalMemoryCost), whose entries keep the
+     * last access and the history (the deltas, if the policy keeps them, and their hash) in the first table, and the
+     * delta in the second one.
+     *
      * @param firstTableCost Pointer to store the cost of the first table.
      * @param secondTableCost Pointer to store the cost of the second table.
      * @return Total memory cost in bytes.
      */
     double getTotalMemoryCosts(double* firstTableCost, double* secondTableCost) {
-        int wordSize = sizeof(T) * 8;
-        int firstTableNumTagBits = wordSize - this->firstTableCacheParams.numIndexBits;
-        double firstTableEntryNumBits = firstTableNumTagBits + wordSize * 2 + 1; // LRU bit
-        int secondTableNumTagBits = wordSize - this->secondTableCacheParams.numIndexBits;
-        double secondTableEntryNumBits = secondTableNumTagBits + wordSize + 1; // LRU bit
-        *firstTableCost = firstTableEntryNumBits * instrHashTable->getNumEntries() / 8.0;
-        *secondTableCost = secondTableEntryNumBits * hashDeltaTable->getNumEntries() / 8.0;
+        *firstTableCost = this->instrHashTable->getTotalMemoryCost();
+        *secondTableCost = this->hashDeltaTable->getTotalMemoryCost();
         return *firstTableCost + *secondTableCost;
     }
 
@@ -411,14 +593,22 @@ public:
      * @param secondTableCost Pointer to store the cost of the second table.
      * @return Total memory cost in bytes.
      */
-	double getMemoryCosts(double* firstTableCost, double* secondTableCost) {
-		int wordSize = sizeof(T) * 8;
-		double firstTableEntryNumBits =  wordSize * 2;
-		double secondTableEntryNumBits =  wordSize; 
-		*firstTableCost = firstTableEntryNumBits * instrHashTable->getNumEntries() / 8.0;
-		*secondTableCost = secondTableEntryNumBits * hashDeltaTable->getNumEntries() / 8.0;
-		return *firstTableCost + *secondTableCost;
-	}
+    double getMemoryCosts(double* firstTableCost, double* secondTableCost) {
+        *firstTableCost = this->instrHashTable->getMemoryCost();
+        *secondTableCost = this->hashDeltaTable->getMemoryCost();
+        return *firstTableCost + *secondTableCost;
+    }
 };
 
-
+/**
+ * @brief HashOnHashDFCM Class that implements a prediction model using hash-based history tables.
+ *
+ * This class models a prediction system based on two-level history caches: one for instructions and another for deltas.
+ * It is used to simulate and predict access patterns for given data based on previous access histories. It is the
+ * DFCMPredictor with the hash-on-hash policy (see HashOnHashPolicy).
+ *
+ * @tparam T Type of instruction and access data.
+ * @tparam Delta Type representing the delta between two accesses.
+ */
+template<typename T, typename Delta>
+using HashOnHashDFCM = DFCMPredictor<T, Delta, HashOnHashPolicy<T>>;
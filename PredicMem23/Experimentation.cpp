@@ -71,12 +71,25 @@ void TracePredictExperimentation::performExperiments() {
 		experiment->clean();
 	}
 	*/
-#pragma omp parallel for schedule(dynamic,1) ordered
+	vector<string> snapshots = vector<string>(experiments.size());
+#pragma omp parallel for schedule(dynamic,1) ordered if(!this->warmState)
 	for (int i = 0; i < experiments.size(); i++) {
-		auto experiment = this->experiments[i];
+		auto experiment = (TracePredictExperiment*)this->experiments[i];
 		cout << "\n=========";
 		cout << "\nEXPERIMENT: " << experiment->getString() << "\n";
+
+		// With warm state, each part of a trace continues from the state of the previous one:
+		if (this->warmState && i > 0 && experiment->isContinuationOf((TracePredictExperiment*)this->experiments[i - 1])) {
+			istringstream snapshot(snapshots[i - 1], ios::binary);
+			experiment->loadState(snapshot);
+		}
 		experiment->performExperiment();
+		if (this->warmState) {
+			ostringstream snapshot(ios::binary);
+			experiment->saveState(snapshot);
+			snapshots[i] = snapshot.str();
+			if (i > 0) snapshots[i - 1] = "";
+		}
 		experiment->clean();
 	}
 
@@ -159,11 +172,14 @@ void TracePredictExperimentation::exportResults(string filename) {
 				// Second node: related to input, cache params:
 				auto cacheParams = params.cacheParams;
 				TiXmlElement* cacheParams_ = new TiXmlElement("cacheParams");
-				if (experiment->getPredictorParams().type == PredictorModelType::BufferSVM) {
+				if (isBufferSVM(experiment->getPredictorParams().type) || isStridePredictor(experiment->getPredictorParams().type)
+					|| isCorrelationPredictor(experiment->getPredictorParams().type)) {
 					cacheParams_->SetAttribute("numIndexBits", cacheParams.numIndexBits);
 					cacheParams_->SetAttribute("numWays", cacheParams.numWays);
 					cacheParams_->SetAttribute("numSequenceAccesses", cacheParams.numSequenceAccesses);
 					cacheParams_->SetAttribute("saveHistoryAndClassIfNotValid", cacheParams.saveHistoryAndClassIfNotValid);
+					if (experiment->getPredictorParams().type == PredictorModelType::GHB)
+						cacheParams_->SetAttribute("historyBufferNumIndexBits", params.additionalCacheParams.numIndexBits);
 					experiment_->LinkEndChild(cacheParams_);
 				}
 				else {
@@ -179,7 +195,7 @@ void TracePredictExperimentation::exportResults(string filename) {
 				
 
 				// Third node: related to input, dictionary params:
-				if (experiment->getPredictorParams().type == PredictorModelType::BufferSVM) {
+				if (isBufferSVM(experiment->getPredictorParams().type)) {
 					auto dictParams = params.dictParams;
 					TiXmlElement* dictParams_ = new TiXmlElement("dictParams");
 					dictParams_->SetAttribute("numClasses", dictParams.numClasses);
@@ -188,6 +204,48 @@ void TracePredictExperimentation::exportResults(string filename) {
 					dictParams_->SetAttribute("saveHistoryAndClassIfNotValid", dictParams.saveHistoryAndClassIfNotValid);
 					experiment_->LinkEndChild(dictParams_);
 				}
+
+				// Fourth node: related to the training of the model (or the hash function of the DFCM):
+				auto modelParams = params.modelParams;
+				TiXmlElement* modelParams_ = new TiXmlElement("modelParams");
+				if (isBufferSVM(experiment->getPredictorParams().type)) {
+					modelParams_->SetAttribute("numBatchSamples", modelParams.numBatchSamples);
+					modelParams_->SetAttribute("updateDelay", modelParams.updateDelay);
+					modelParams_->SetAttribute("numShards", modelParams.numShards);
+					modelParams_->SetAttribute("shardByCacheSet", modelParams.shardByCacheSet);
+					if (experiment->getPredictorParams().type != PredictorModelType::HybridSVMDFCM)
+						modelParams_->SetAttribute("predictionDegree", modelParams.predictionDegree);
+					else {
+						for (auto& [name, hashType] : stringToDFCMHashTable)
+							if (hashType == modelParams.dfcmHashType)
+								modelParams_->SetAttribute("dfcmHashType", name.c_str());
+						modelParams_->SetAttribute("numChooserIndexBits", modelParams.numChooserIndexBits);
+						modelParams_->SetAttribute("dfcmNumConfidenceBits", modelParams.dfcmNumConfidenceBits);
+						modelParams_->SetAttribute("dfcmConfidenceThreshold", modelParams.dfcmConfidenceThreshold);
+					}
+				}
+				else if (experiment->getPredictorParams().type == PredictorModelType::DFCM) {
+					for (auto& [name, hashType] : stringToDFCMHashTable)
+						if (hashType == modelParams.dfcmHashType)
+							modelParams_->SetAttribute("dfcmHashType", name.c_str());
+					modelParams_->SetAttribute("predictionDegree", modelParams.predictionDegree);
+					modelParams_->SetAttribute("dfcmNumConfidenceBits", modelParams.dfcmNumConfidenceBits);
+					modelParams_->SetAttribute("dfcmConfidenceThreshold", modelParams.dfcmConfidenceThreshold);
+				}
+				experiment_->LinkEndChild(modelParams_);
+
+				// Fifth node: related to the data caches fed with the predictions as prefetches (if they are simulated):
+				auto prefetchCacheParams = params.prefetchCacheParams;
+				if (prefetchCacheParams.isSimulated) {
+					TiXmlElement* prefetchCacheParams_ = new TiXmlElement("prefetchCacheParams");
+					prefetchCacheParams_->SetAttribute("numLineBits", prefetchCacheParams.numLineBits);
+					prefetchCacheParams_->SetAttribute("numL1IndexBits", prefetchCacheParams.numL1IndexBits);
+					prefetchCacheParams_->SetAttribute("numL1Ways", prefetchCacheParams.numL1Ways);
+					prefetchCacheParams_->SetAttribute("numL2IndexBits", prefetchCacheParams.numL2IndexBits);
+					prefetchCacheParams_->SetAttribute("numL2Ways", prefetchCacheParams.numL2Ways);
+					prefetchCacheParams_->SetAttribute("prefetchLatency", prefetchCacheParams.prefetchLatency);
+					experiment_->LinkEndChild(prefetchCacheParams_);
+				}
 			
 				trace->LinkEndChild(experiment_);
 				for (auto it = results.begin(); it != results.end(); it++) {
@@ -246,6 +304,8 @@ void TracePredictExperimentation::performAndExportExperimentations(string specsF
 	long numAccessesPerExperiment = 0L; 
 	string outputFilename; 
 	bool countTotalMemory = false;
+	bool warmState = false;
+	bool analyzeGeometries = false;
 	
 	TiXmlDocument doc(specsFilePath);
 	doc.LoadFile();
@@ -270,6 +330,12 @@ void TracePredictExperimentation::performAndExportExperimentations(string specsF
 		else if (elemName == "countTotalMemory") {
 			countTotalMemory = (bool)std::stoi(element->GetText());
 		}
+		else if (elemName == "warmState") {
+			warmState = (bool)std::stoi(element->GetText());
+		}
+		else if (elemName == "analyzeHistoryCacheGeometries") {
+			analyzeGeometries = (bool)std::stoi(element->GetText());
+		}
 	}
 
 	if (numAccessesPerExperiment <= 0) {
@@ -278,38 +344,193 @@ void TracePredictExperimentation::performAndExportExperimentations(string specsF
 		throw std::invalid_argument(msg);
 	}
 
+	// The analysis mode only obtains the history cache-miss rates of the geometries of the sweep:
+	if (analyzeGeometries) {
+		auto missRates = TracePredictExperimentation::analyzeHistoryCacheGeometries(tracesInfo, params.cacheParams,
+			numAccessesPerExperiment);
+		TracePredictExperimentation::exportHistoryCacheGeometries(missRates, outputFilename);
+		return;
+	}
+
 	TracePredictExperimentation::performAndExportExperimentations(tracesInfo, params, numAccessesPerExperiment, 
-		outputFilename, countTotalMemory);
+		outputFilename, countTotalMemory, warmState);
 }
 
 void TracePredictExperimentation::performAndExportExperimentations(vector<TraceInfo> tracesInfo,
-	PredictorParametersDomain params, long numAccessesPerExperiment, string outputFilename, bool countTotalMemory = false) {
+	PredictorParametersDomain params, long numAccessesPerExperiment, string outputFilename, bool countTotalMemory = false,
+	bool warmState = false) {
 	vector<PredictorParameters> allPredictorParams = decomposePredictorParametersDomain(params);
-	int i = 0;
-	// std::string baseName = outputFilename.substr(outputFilename.find_last_of("/\\") + 1);
-	auto path = fs::path(outputFilename);
-	string directory = path.parent_path().string();
-	if (directory == "")
-		directory = ".";
-	std::string baseName = path.stem().string();
-	std::string extension = path.extension().string();
-	for (auto& predictorParams : allPredictorParams) {
-		ostringstream file_;
-		file_ << directory << "\\" << baseName << "_" << to_string(i) << extension;
-		string file = file_.str();
-		// res.push_back(TracePredictExperimentation(file, countTotalMemory));
-		auto experimentation = TracePredictExperimentation(file, countTotalMemory);
-		experimentation.buildExperiments(tracesInfo, predictorParams, numAccessesPerExperiment);
-		experimentation.performExperiments();
-		experimentation.exportResults();
-		i++;
+
+	// The experimentations are built, performed and exported in groups, so that each trace is read (and the buffers
+	// simulated) once per group, without holding the models and datasets of the whole sweep at the same time:
+	int numSharedSimulations = 16;
+	for (int first = 0; first < allPredictorParams.size(); first += numSharedSimulations) {
+		int last = std::min<int>(first + numSharedSimulations, allPredictorParams.size());
+		vector<TracePredictExperimentation> experimentations;
+		TracePredictExperimentation::createAndBuildExperimentations(experimentations, tracesInfo, allPredictorParams,
+			first, last, numAccessesPerExperiment, outputFilename, countTotalMemory);
+		for (auto& experimentation : experimentations)
+			experimentation.warmState = warmState;
+		TracePredictExperimentation::performExperimentationsSharingTraces(experimentations, numSharedSimulations);
+		for (auto& experimentation : experimentations)
+			experimentation.exportResults();
+	}
+}
+
+void TracePredictExperimentation::performExperimentationsSharingTraces(vector<TracePredictExperimentation>& experimentations,
+	int numSharedSimulations) {
+	if (experimentations.size() == 0)
+		return;
+
+	auto framework = &experimentations[0];
+	int numExperiments = framework->experiments.size();
+	for (auto& experimentation : experimentations) {
+		if (experimentation.experiments.size() != numExperiments) {
+			string msg = string("ERROR: The experimentations do not share the same trace parts!\n");
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+
+	// With warm state, the parts are performed in order, each one from the snapshots of the previous one:
+	bool warmState = framework->warmState;
+	vector<string> snapshots = vector<string>(experimentations.size());
+
+	omp_set_num_threads(framework->numWorkingThreads);
+#pragma omp parallel for schedule(dynamic,1) ordered if(!warmState)
+	for (int i = 0; i < numExperiments; i++) {
+		// The i-th experiments of all the experimentations work on the same part of the same trace:
+		vector<TracePredictExperiment*> experiments = vector<TracePredictExperiment*>();
+		for (auto& experimentation : experimentations)
+			experiments.push_back((TracePredictExperiment*)experimentation.experiments[i]);
+
+		for (int e = 0; e < experiments.size(); e++) {
+			if (warmState && i > 0 && experiments[e]->isContinuationOf(
+				(TracePredictExperiment*)experimentations[e].experiments[i - 1])) {
+				istringstream snapshot(snapshots[e], ios::binary);
+				experiments[e]->loadState(snapshot);
+			}
+		}
+
+		AccessesDataset<L64bu, L64bu> dataset;
+#pragma omp ordered
+		{
+		// Next, we read the trace and extract the working dataset (only once):
+		dataset = experiments[0]->readDataset();
+		}
+
+		// The buffers of the BufferSVM experiments are simulated in groups over the same pass:
+		vector<int> buffersExperiments = vector<int>();
+		for (int e = 0; e < experiments.size(); e++) {
+			auto experiment = experiments[e];
+			if (isBufferSVM(experiment->getPredictorParams().type) && dataset.accesses.size() > 0)
+				buffersExperiments.push_back(e);
+			else {
+				cout << "\n=========";
+				cout << "\nEXPERIMENT: " << experiment->getString() << "\n";
+				BuffersDataset<int> classesDataset;
+				experiment->performExperiment(dataset, classesDataset);
+				if (warmState) {
+					ostringstream snapshot(ios::binary);
+					experiment->saveState(snapshot);
+					snapshots[e] = snapshot.str();
+				}
+				experiment->clean();
+			}
+		}
+
+		for (int first = 0; first < buffersExperiments.size(); first += numSharedSimulations) {
+			int last = std::min<int>(first + numSharedSimulations, buffersExperiments.size());
+			MultiBuffersSimulator<L64bu, L64bu, int, L64bu, L64b> simulator;
+			for (int k = first; k < last; k++)
+				simulator.addSimulator(experiments[buffersExperiments[k]]->getBuffersSimulator());
+			vector<BuffersDataset<int>> classesDatasets = simulator.simulate(dataset);
+
+			for (int k = first; k < last; k++) {
+				int e = buffersExperiments[k];
+				auto experiment = experiments[e];
+				cout << "\n=========";
+				cout << "\nEXPERIMENT: " << experiment->getString() << "\n";
+				experiment->performExperiment(dataset, classesDatasets[k - first]);
+				if (warmState) {
+					ostringstream snapshot(ios::binary);
+					experiment->saveState(snapshot);
+					snapshots[e] = snapshot.str();
+				}
+				experiment->clean();
+				classesDatasets[k - first] = {};
+			}
+		}
+
+		dataset = {};
+	}
+}
+
+map<string, map<pair<int, int>, double>> TracePredictExperimentation::analyzeHistoryCacheGeometries(vector<TraceInfo> tracesInfo,
+	CacheParametersDomain cacheParams, long numAccessesPerExperiment) {
+	HistoryCacheGeometryAnalyzer<L64bu, L64bu> analyzer(cacheParams);
+	map<string, map<pair<int, int>, double>> res;
+
+	for (auto& traceInfo : tracesInfo) {
+		TraceReader<L64bu, L64bu> reader(traceInfo.filename);
+		vector<map<pair<int, int>, double>> partsMissRates;
+		for (unsigned long k = 0; k < traceInfo.numAccesses; k += numAccessesPerExperiment) {
+			unsigned long k1 = std::min<unsigned long>(k + numAccessesPerExperiment, traceInfo.numAccesses);
+			auto dataset = reader.readLines(k, k1);
+			if (dataset.accesses.size() == 0)
+				continue;
+
+			// Every part starts from empty caches, like the buffers of its experiment:
+			analyzer.clean();
+			analyzer.analyze(dataset);
+			partsMissRates.push_back(analyzer.getCacheMissRates());
+		}
+
+		auto& missRates = res[traceInfo.name];
+		for (auto& partMissRates : partsMissRates) {
+			for (auto& [geometry, missRate] : partMissRates)
+				missRates[geometry] += missRate / partsMissRates.size();
+		}
+		for (auto& [geometry, missRate] : missRates)
+			printf("\nCache miss rate of %s (%d index bits, %d ways): %f", traceInfo.name.c_str(), geometry.first,
+				geometry.second, missRate);
 	}
+	return res;
+}
+
+void TracePredictExperimentation::exportHistoryCacheGeometries(map<string, map<pair<int, int>, double>>& missRates,
+	string filename) {
+	TiXmlDocument doc;
+	TiXmlDeclaration decl("1.0", "", "");
+	doc.InsertEndChild(decl);
+
+	TiXmlElement* traces = new TiXmlElement("Traces");
+	for (auto& [traceName, traceMissRates] : missRates) {
+		TiXmlElement* trace = new TiXmlElement(traceName.c_str());
+		for (auto& [geometry, missRate] : traceMissRates) {
+			TiXmlElement* cacheParams_ = new TiXmlElement("cacheParams");
+			cacheParams_->SetAttribute("numIndexBits", geometry.first);
+			cacheParams_->SetAttribute("numWays", geometry.second);
+			cacheParams_->SetDoubleAttribute("cacheMissRate", missRate);
+			trace->LinkEndChild(cacheParams_);
+		}
+		traces->LinkEndChild(trace);
+	}
+	doc.LinkEndChild(traces);
+
+	doc.SaveFile(filename.c_str());
 }
 
  void TracePredictExperimentation::createAndBuildExperimentations(vector<TracePredictExperimentation>& res, vector<TraceInfo> tracesInfo,
 	PredictorParametersDomain params, long numAccessesPerExperiment, string outputFilename, bool countTotalMemory = false) {
 	vector<PredictorParameters> allPredictorParams = decomposePredictorParametersDomain(params);
-	int i = 0;
+	TracePredictExperimentation::createAndBuildExperimentations(res, tracesInfo, allPredictorParams, 0, allPredictorParams.size(),
+		numAccessesPerExperiment, outputFilename, countTotalMemory);
+}
+
+void TracePredictExperimentation::createAndBuildExperimentations(vector<TracePredictExperimentation>& res, vector<TraceInfo> tracesInfo,
+	vector<PredictorParameters>& allPredictorParams, int first, int last, long numAccessesPerExperiment, string outputFilename,
+	bool countTotalMemory) {
 	// std::string baseName = outputFilename.substr(outputFilename.find_last_of("/\\") + 1);
 	auto path = fs::path(outputFilename);
 	string directory = path.parent_path().string();
@@ -317,21 +538,114 @@ void TracePredictExperimentation::performAndExportExperimentations(vector<TraceI
 		directory = ".";
 	std::string baseName = path.stem().string();
 	std::string extension = path.extension().string();
-	res = vector<TracePredictExperimentation>(allPredictorParams.size());
-	for (auto& predictorParams : allPredictorParams) {
+	res = vector<TracePredictExperimentation>(last - first);
+	for (int i = first; i < last; i++) {
+		auto& predictorParams = allPredictorParams[i];
 		ostringstream file_;
 		file_ << directory << "\\" << baseName << "_" << to_string(i) << extension;
 		string file = file_.str();
 		// res.push_back(TracePredictExperimentation(file, countTotalMemory));
-		res[i] = TracePredictExperimentation(file, countTotalMemory);
-		res[i].buildExperiments(tracesInfo, predictorParams, numAccessesPerExperiment);
+		res[i - first] = TracePredictExperimentation(file, countTotalMemory);
+		res[i - first].buildExperiments(tracesInfo, predictorParams, numAccessesPerExperiment);
 		// auto t = TracePredictExperimentation(file, countTotalMemory);
 		// t.buildExperiments(tracesInfo, predictorParams, numAccessesPerExperiment);
 		// res.push_back(t);
-		i++;
 	}
 }
 
+/**
+ * @brief Create the data caches fed with the predictions of a model as prefetches.
+ * @param params Prefetch cache parameters.
+ * @return The simulator of the caches (nullptr if the prefetches are not simulated).
+ */
+static shared_ptr<PrefetchCacheSimulator<L64bu>> createPrefetchSimulator(PrefetchCacheParameters params) {
+	if (!params.isSimulated)
+		return nullptr;
+	return make_shared<PrefetchCacheSimulator<L64bu>>(params);
+}
+
+/**
+ * @brief Build an SVM with a given classifier, configured with the predictor parameters.
+ * @tparam T_pred Type of the multi-class classifier.
+ * @param params Predictor parameters.
+ * @param inputEncoding Encoding of the input history.
+ * @return The SVM.
+ */
+template<typename T_pred>
+static SVM<T_pred, int>* newBufferSVM(PredictorParameters params, SVMInputEncoding inputEncoding = SVMInputEncoding::Scaled) {
+	auto svm = new SVM<T_pred, int>(params.cacheParams.numSequenceAccesses, params.dictParams.numClasses,
+		params.cacheParams.saveHistoryAndClassIfNotValid, inputEncoding);
+	svm->numBatchSamples = params.modelParams.numBatchSamples;
+	svm->updateDelay = params.modelParams.updateDelay;
+	svm->numShards = params.modelParams.numShards;
+	svm->shardingType = params.modelParams.shardByCacheSet ? SVMShardingType::CacheSet : SVMShardingType::PCHash;
+	svm->numShardIndexBits = params.cacheParams.numIndexBits;
+	svm->predictionDegree = params.modelParams.predictionDegree;
+	return svm;
+}
+
+/**
+ * @brief Create an SVM predictor with a given classifier, configured with the predictor parameters.
+ * @tparam T_pred Type of the multi-class classifier.
+ * @param params Predictor parameters.
+ * @param inputEncoding Encoding of the input history.
+ * @return The SVM predictor model.
+ */
+template<typename T_pred>
+static shared_ptr<PredictorModel<L64bu, int>> createBufferSVM(PredictorParameters params,
+	SVMInputEncoding inputEncoding = SVMInputEncoding::Scaled) {
+	auto svm = newBufferSVM<T_pred>(params, inputEncoding);
+	svm->prefetchSimulator = createPrefetchSimulator(params.prefetchCacheParams);
+	return shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*) svm);
+}
+
+/**
+ * @brief Create the SVM of a BufferSVM predictor, with the backend of weights and the input encoding of its type.
+ * @param params Predictor parameters.
+ * @return The SVM predictor model.
+ */
+static shared_ptr<PredictorModel<L64bu, int>> createBufferSVM(PredictorParameters params) {
+	switch (params.type) {
+	case PredictorModelType::BufferSVMDouble:
+		return createBufferSVM<MultiSVMClassifierOneToAll>(params);
+	case PredictorModelType::BufferSVMInt16:
+		return createBufferSVM<MultiSVMClassifierOneToAllInt16>(params);
+	case PredictorModelType::BufferSVMInt8:
+		return createBufferSVM<MultiSVMClassifierOneToAllInt8>(params);
+	case PredictorModelType::BufferSVMOneHot:
+		return createBufferSVM<MultiSVMClassifierOneToAllFloat>(params, SVMInputEncoding::OneHot);
+	case PredictorModelType::BufferSVMHashed:
+		return createBufferSVM<MultiSVMClassifierOneToAllFloat>(params, SVMInputEncoding::Hashed);
+	default:
+		return createBufferSVM<MultiSVMClassifierOneToAllFloat>(params);
+	}
+}
+
+/**
+ * @brief Create the hybrid of a BufferSVM (float32) and a KOrderDFCM with a per-PC chooser.
+ *
+ * The first table of the DFCM has the geometry and the order (numSequenceAccesses) of the history cache of the SVM,
+ * and the second one the additional cache parameters.
+ * @param params Predictor parameters.
+ * @param cacheType Type of the history caches.
+ * @param countTotalMemory Whether to count the total memory (tags and LRU bits included).
+ * @return The hybrid predictor model.
+ */
+static shared_ptr<PredictorModel<L64bu, int>> createHybridPredictor(PredictorParameters params, HistoryCacheType cacheType,
+	bool countTotalMemory) {
+	auto svm = shared_ptr<SVM<MultiSVMClassifierOneToAllFloat, int>>(newBufferSVM<MultiSVMClassifierOneToAllFloat>(params));
+	// The chooser only picks between the predictions of the next access:
+	svm->predictionDegree = 1;
+	auto dfcm = shared_ptr<KOrderDFCM<L64bu, L64b>>(new KOrderDFCM<L64bu, L64b>(cacheType, params.cacheParams,
+		params.additionalCacheParams, countTotalMemory, params.modelParams.dfcmHashType));
+	dfcm->setConfidence(params.modelParams.dfcmNumConfidenceBits, params.modelParams.dfcmConfidenceThreshold);
+	auto hybrid = new HybridPredictor<MultiSVMClassifierOneToAllFloat, L64b>(svm, dfcm, params.modelParams.numChooserIndexBits,
+		countTotalMemory);
+	// The prefetches of both components are issued by the hybrid, as the chooser picks them:
+	hybrid->prefetchSimulator = createPrefetchSimulator(params.prefetchCacheParams);
+	return shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*) hybrid);
+}
+
 TracePredictExperiment::TracePredictExperiment(string traceFilename, string traceName, long startLine, long endLine, 
 	struct PredictorParameters params, bool countTotalMemory) {
 	this->traceFilename = traceFilename;
@@ -346,16 +660,30 @@ TracePredictExperiment::TracePredictExperiment(string traceFilename, string trac
 	
 	HistoryCacheType cacheType = (cacheParams.numIndexBits > 0)? HistoryCacheType::Real : HistoryCacheType::Infinite;
 
-	if (params.type == PredictorModelType::BufferSVM) {
+	if (isBufferSVM(params.type)) {
 		this->buffersSimulator = BuffersSimulator<L64bu, L64bu, int, L64bu, L64b>(cacheType, cacheParams, dictParams);
-		this->model = shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*)
-			new SVM<MultiSVMClassifierOneToAll, int>(cacheParams.numSequenceAccesses, dictParams.numClasses, 
-				cacheParams.saveHistoryAndClassIfNotValid));
+		// The predictions can only be prefetched with the last accesses and the deltas of the classes:
+		this->buffersSimulator.recordLastAccesses = params.prefetchCacheParams.isSimulated;
+		this->model = params.type == PredictorModelType::HybridSVMDFCM ?
+			createHybridPredictor(params, cacheType, this->countTotalMemory) : createBufferSVM(params);
+	}
+	else if (isStridePredictor(params.type)) {
+		auto stride = new StridePredictor<L64bu, L64b>(cacheType, cacheParams, params.type == PredictorModelType::TwoDeltaStride);
+		stride->prefetchSimulator = createPrefetchSimulator(params.prefetchCacheParams);
+		this->model = shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*) stride);
+	}
+	else if (isCorrelationPredictor(params.type)) {
+		auto correlation = new CorrelationPredictor<L64bu, L64b>(cacheType, cacheParams, params.additionalCacheParams,
+			params.type == PredictorModelType::GHB);
+		correlation->prefetchSimulator = createPrefetchSimulator(params.prefetchCacheParams);
+		this->model = shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*) correlation);
 	}
 	else {
-		this->model = 
-			shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*) 
-				new HashOnHashDFCM<L64bu, L64b>(cacheType, cacheParams, params.additionalCacheParams));
+		auto dfcm = new HashOnHashDFCM<L64bu, L64b>(cacheType, cacheParams, params.additionalCacheParams);
+		dfcm->predictionDegree = params.modelParams.predictionDegree;
+		dfcm->setConfidence(params.modelParams.dfcmNumConfidenceBits, params.modelParams.dfcmConfidenceThreshold);
+		dfcm->prefetchSimulator = createPrefetchSimulator(params.prefetchCacheParams);
+		this->model = shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*) dfcm);
 	}
 	
 	this->startDateTime = nowDateTime();
@@ -376,21 +704,42 @@ TracePredictExperiment::TracePredictExperiment(TracePredictExperimentation* fram
 
 	HistoryCacheType cacheType = (cacheParams.numIndexBits >= 0) ? HistoryCacheType::Real : HistoryCacheType::Infinite;
 
-	if (params.type == PredictorModelType::BufferSVM) {
+	if (isBufferSVM(params.type)) {
 		this->buffersSimulator = BuffersSimulator<L64bu, L64bu, int, L64bu, L64b>(cacheType, cacheParams, dictParams);
-		this->model = shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*)
-			new SVM<MultiSVMClassifierOneToAll, int>(cacheParams.numSequenceAccesses, dictParams.numClasses, 
-				cacheParams.saveHistoryAndClassIfNotValid));
+		// The predictions can only be prefetched with the last accesses and the deltas of the classes:
+		this->buffersSimulator.recordLastAccesses = params.prefetchCacheParams.isSimulated;
+		this->model = params.type == PredictorModelType::HybridSVMDFCM ?
+			createHybridPredictor(params, cacheType, this->countTotalMemory) : createBufferSVM(params);
+	}
+	else if (isStridePredictor(params.type)) {
+		auto stride = new StridePredictor<L64bu, L64b>(cacheType, cacheParams,
+			params.type == PredictorModelType::TwoDeltaStride, this->countTotalMemory);
+		stride->prefetchSimulator = createPrefetchSimulator(params.prefetchCacheParams);
+		this->model = shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*) stride);
+	}
+	else if (isCorrelationPredictor(params.type)) {
+		auto correlation = new CorrelationPredictor<L64bu, L64b>(cacheType, cacheParams, params.additionalCacheParams,
+			params.type == PredictorModelType::GHB, this->countTotalMemory);
+		correlation->prefetchSimulator = createPrefetchSimulator(params.prefetchCacheParams);
+		this->model = shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*) correlation);
 	}
 	else {
-		if(params.cacheParams.numSequenceAccesses > 0)
-			this->model = shared_ptr<PredictorModel<L64bu, int>>(
-				(PredictorModel<L64bu, int>*) new KOrderDFCM<L64bu, L64b>(cacheType, cacheParams, params.additionalCacheParams,
-					this->countTotalMemory));
-		else
-			this->model = shared_ptr<PredictorModel<L64bu, int>>(
-				(PredictorModel<L64bu, int>*) new HashOnHashDFCM<L64bu, L64b>(cacheType, cacheParams, params.additionalCacheParams,
-					this->countTotalMemory));
+		if (params.cacheParams.numSequenceAccesses > 0) {
+			auto dfcm = new KOrderDFCM<L64bu, L64b>(cacheType, cacheParams, params.additionalCacheParams,
+				this->countTotalMemory, params.modelParams.dfcmHashType);
+			dfcm->predictionDegree = params.modelParams.predictionDegree;
+			dfcm->setConfidence(params.modelParams.dfcmNumConfidenceBits, params.modelParams.dfcmConfidenceThreshold);
+			dfcm->prefetchSimulator = createPrefetchSimulator(params.prefetchCacheParams);
+			this->model = shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*) dfcm);
+		}
+		else {
+			auto dfcm = new HashOnHashDFCM<L64bu, L64b>(cacheType, cacheParams, params.additionalCacheParams,
+				this->countTotalMemory);
+			dfcm->predictionDegree = params.modelParams.predictionDegree;
+			dfcm->setConfidence(params.modelParams.dfcmNumConfidenceBits, params.modelParams.dfcmConfidenceThreshold);
+			dfcm->prefetchSimulator = createPrefetchSimulator(params.prefetchCacheParams);
+			this->model = shared_ptr<PredictorModel<L64bu, int>>((PredictorModel<L64bu, int>*) dfcm);
+		}
 	}
 	this->startDateTime = nowDateTime();
 }
@@ -453,11 +802,7 @@ bool TracePredictExperiment::isNull() {
 	return this->isNull_;
 }
 
-void TracePredictExperiment::performExperiment() {
-	this->startDateTime = nowDateTime();
-	AccessesDataset<L64bu, L64bu> dataset;
-#pragma omp ordered
-	{
+AccessesDataset<L64bu, L64bu> TracePredictExperiment::readDataset() {
 	// First, we check that we don't have to instantiate a new TraceReader:
 	bool isSameFile = this->framework->traceReader.filename == this->traceFilename;
 	bool isFileOpen = this->framework->traceReader.file.is_open();
@@ -472,22 +817,50 @@ void TracePredictExperiment::performExperiment() {
 	}
 
 	// Next, we read the trace and extract the working dataset:
-	dataset = this->framework->traceReader.readLines(startLine, endLine);
+	return this->framework->traceReader.readLines(startLine, endLine);
+}
+
+void TracePredictExperiment::performExperiment() {
+	AccessesDataset<L64bu, L64bu> dataset;
+#pragma omp ordered
+	{
+	dataset = this->readDataset();
 	}
 	BuffersDataset<int> classesDataset;
 
-	if (dataset.accesses.size() > 0) {
+	if (dataset.accesses.size() > 0 && isBufferSVM(this->predictorParams.type)) {
+		// Now we simulate the buffers and extract the final dataset:
+		classesDataset = this->buffersSimulator.simulate(dataset);
+	}
 
-		if (this->predictorParams.type == PredictorModelType::BufferSVM) {
-			// Now we simulate the buffers and extract the final dataset:
-			classesDataset = this->buffersSimulator.simulate(dataset);
-		}
+	this->performExperiment(dataset, classesDataset);
+
+	/*
+	dataset.accesses.clear();
+	dataset.accessesInstructions.clear();
+	classesDataset.inputAccesses.clear();
+	classesDataset.outputAccesses.clear();
+	classesDataset.isValid.clear();
+	classesDataset.isCacheMiss.clear();
+	classesDataset.isDictionaryMiss.clear();
+	*/
+	// this->model->clean();
+	// buffersSimulator.clean();
+	dataset = {};
+	classesDataset = {};
+}
+
+void TracePredictExperiment::performExperiment(AccessesDataset<L64bu, L64bu>& dataset, BuffersDataset<int>& classesDataset) {
+	this->startDateTime = nowDateTime();
+
+	if (dataset.accesses.size() > 0) {
 
 		// Finally, we simulate the predictor model and extract metrics from results:
 		this->model->importData(dataset, classesDataset);
-		resultsAndCosts = this->model->simulate();
+		// A model restored from a snapshot continues from its trained state:
+		resultsAndCosts = this->model->simulate(!this->isWarm);
 
-		if (this->predictorParams.type == PredictorModelType::BufferSVM) {
+		if (isBufferSVM(this->predictorParams.type)) {
 			BuffersSVMPredictResultsAndCosts* rc = (BuffersSVMPredictResultsAndCosts*)resultsAndCosts.get();
 			if (countTotalMemory) {
 				rc->cacheMemoryCost = buffersSimulator.historyCache->getTotalMemoryCost();
@@ -503,26 +876,25 @@ void TracePredictExperiment::performExperiment() {
 		
 	}
 	else this->isNull_ = true;
-
-	/*
-	dataset.accesses.clear();
-	dataset.accessesInstructions.clear();
-	classesDataset.inputAccesses.clear();
-	classesDataset.outputAccesses.clear();
-	classesDataset.isValid.clear();
-	classesDataset.isCacheMiss.clear();
-	classesDataset.isDictionaryMiss.clear();
-	*/
-	// this->model->clean();
-	// buffersSimulator.clean();
-	dataset = {};
-	classesDataset = {};
 }
 
 string TracePredictExperiment::getName() {
 	return this->traceName;
 }
 
+void TracePredictExperiment::saveState(ostream& os) {
+	if (isBufferSVM(this->predictorParams.type))
+		this->buffersSimulator.save(os);
+	this->model->save(os);
+}
+
+void TracePredictExperiment::loadState(istream& is) {
+	if (isBufferSVM(this->predictorParams.type))
+		this->buffersSimulator.load(is);
+	this->model->load(is);
+	this->isWarm = true;
+}
+
 void TracePredictExperiment::clean() {
 	// buffersSimulator.clean();
 	// model.reset();
@@ -44,6 +44,10 @@
 #include "BuffersSimulator.h"
 #include "DFCM.h"
 #include "KOrderDFCM.h"
+#include "StridePredictor.h"
+#include "CorrelationPredictor.h"
+#include "HybridPredictor.h"
+#include "PrefetchCacheSimulator.h"
 
 /**
  * @brief Abstract class representing a single experiment.
@@ -189,6 +193,21 @@ public:
 	static void createAndBuildExperimentations(vector<TracePredictExperimentation>& res, vector<TraceInfo> tracesInfo, PredictorParametersDomain,
 		long numAccessesPerExperiment, string outputFilename, bool countTotalMemory);
 
+	/**
+	* @brief Static method to create and build the experimentations of a range of predictor parameters of a sweep.
+	* @param res Vector to store the created TracePredictExperimentation objects.
+	* @param tracesInfo Vector of trace information.
+	* @param allPredictorParams All the predictor parameters of the sweep.
+	* @param first Index of the first predictor parameters of the range (it also numbers the output files).
+	* @param last Index after the last predictor parameters of the range.
+	* @param numAccessesPerExperiment Number of accesses per experiment.
+	* @param outputFilename Output filename for results.
+	* @param countTotalMemory Flag to indicate if total memory should be counted.
+	*/
+	static void createAndBuildExperimentations(vector<TracePredictExperimentation>& res, vector<TraceInfo> tracesInfo,
+		vector<PredictorParameters>& allPredictorParams, int first, int last, long numAccessesPerExperiment,
+		string outputFilename, bool countTotalMemory);
+
 	/**
 	 * @brief Static method to perform and export experimentations.
 	 * @param tracesInfo Vector of trace information.
@@ -196,17 +215,57 @@ public:
 	 * @param numAccessesPerExperiment Number of accesses per experiment.
 	 * @param outputFilename Output filename for results.
 	 * @param countTotalMemory Flag to indicate if total memory should be counted.
+	 * @param warmState Flag to continue each part of a trace from the state of the previous one.
 	 */
 	static void performAndExportExperimentations(vector<TraceInfo> tracesInfo,
-		PredictorParametersDomain params, long numAccessesPerExperiment, string outputFilename, bool countTotalMemory);
+		PredictorParametersDomain params, long numAccessesPerExperiment, string outputFilename, bool countTotalMemory,
+		bool warmState);
 
 	/**
 	 * @brief Static method to perform and export experimentations.
 	 * @param specsFilePath Path of the XML file that contains all info related to (1) the traces, (2) the predicor's parameters
-	 * (3) the number of accesses per experiment, (4) the output file path and (5) if the total memory cost should be counted.
+	 * (3) the number of accesses per experiment, (4) the output file path, (5) if the total memory cost should be counted
+	 * and (6) if the parts of a trace continue from the state of the previous one (warmState).
+	 * If (7) analyzeHistoryCacheGeometries is set, only the history cache-miss rates of the cacheParams domain are
+	 * obtained (see analyzeHistoryCacheGeometries) and exported to the output file, instead of performing the experiments.
 	 */
 	static void performAndExportExperimentations(string specsFilePath);
 
+	/**
+	 * @brief Static method to perform the experiments of several experimentations sharing the passes over the traces.
+	 *
+	 * All the experimentations must have been built from the same traces and number of accesses per experiment
+	 * (e.g., with createAndBuildExperimentations), so that their i-th experiments cover the same part of the same trace.
+	 * Each part is then read once, and the buffers of all the BufferSVM experiments on it are simulated in lock-step
+	 * with a MultiBuffersSimulator (in groups of, at most, numSharedSimulations configurations).
+	 * If the experimentations have warmState set, the parts are performed in order, each one from the state of the previous one.
+	 * @param experimentations Vector of experimentations to perform.
+	 * @param numSharedSimulations Maximum number of buffers configurations simulated in the same pass.
+	 */
+	static void performExperimentationsSharingTraces(vector<TracePredictExperimentation>& experimentations,
+		int numSharedSimulations = 16);
+
+	/**
+	 * @brief Static method to obtain the history cache-miss rates of all the geometries of a cache parameters domain in one pass.
+	 *
+	 * Each part of numAccessesPerExperiment accesses is analyzed from empty caches, as the experiments do,
+	 * with a HistoryCacheGeometryAnalyzer, instead of simulating the buffers of every (numIndexBits, numWays) point separately.
+	 * The rates of a trace are the mean of those of its parts, as in exportResults.
+	 * @param tracesInfo Vector of trace information.
+	 * @param cacheParams Domain of cache parameters.
+	 * @param numAccessesPerExperiment Number of accesses per experiment.
+	 * @return Map from trace name to the map from (numIndexBits, numWays) to cache-miss rate.
+	 */
+	static map<string, map<pair<int, int>, double>> analyzeHistoryCacheGeometries(vector<TraceInfo> tracesInfo,
+		CacheParametersDomain cacheParams, long numAccessesPerExperiment = 10000000);
+
+	/**
+	 * @brief Static method to export the history cache-miss rates given by analyzeHistoryCacheGeometries to a file.
+	 * @param missRates Map from trace name to the map from (numIndexBits, numWays) to cache-miss rate.
+	 * @param filename The name of the file to export the rates to.
+	 */
+	static void exportHistoryCacheGeometries(map<string, map<pair<int, int>, double>>& missRates, string filename);
+
 	TraceReader<L64bu, L64bu> traceReader; ///< Trace reader.
 
 	/**
@@ -231,6 +290,9 @@ public:
 	
 	/**
 	 * @brief Perform all experiments in the collection.
+	 *
+	 * If warmState is set, the experiments are performed in order, and each part of a trace is restored
+	 * from a snapshot of the state of the previous part instead of starting with cold buffers and model.
 	 */
 	void performExperiments();
 	/**
@@ -268,6 +330,7 @@ public:
 	map<string, vector<Experiment*>> getExperimentsByTrace();
 	 
 	int numWorkingThreads = 8; ///< Number of working threads.
+	bool warmState = false; ///< Flag to continue each part of a trace from the state of the previous one.
 };
 
 
@@ -283,6 +346,7 @@ private:
 	string startDateTime; ///< Start date and time.
 	bool countTotalMemory = false; ///< Flag to indicate if total memory should be counted.
 	bool isNull_ = false; ///< Flag to indicate if the experiment is null.
+	bool isWarm = false; ///< Flag to indicate if the state of the experiment was restored from a snapshot.
 
 	BuffersSimulator<L64bu, L64bu, int, L64bu, L64b> buffersSimulator = BuffersSimulator<L64bu, L64bu, int, L64bu, L64b>();
 	shared_ptr<PredictorModel<L64bu, int>> model; ///< Predictor model.
@@ -378,6 +442,47 @@ public:
 	* @brief Perform the experiment.
 	*/
 	void performExperiment();
+	/**
+	 * @brief Perform the experiment on an already read dataset and, for BufferSVM models, its simulated buffers.
+	 * @param dataset The dataset of accesses of the experiment.
+	 * @param classesDataset The buffers dataset generated by the buffers simulator of this experiment.
+	 */
+	void performExperiment(AccessesDataset<L64bu, L64bu>& dataset, BuffersDataset<int>& classesDataset);
+	/**
+	 * @brief Read the dataset of accesses of the experiment through the trace reader of the framework.
+	 * @return The dataset of accesses.
+	 */
+	AccessesDataset<L64bu, L64bu> readDataset();
+	/**
+	 * @brief Get the buffers simulator of the experiment.
+	 * @return Pointer to the buffers simulator.
+	 */
+	BuffersSimulator<L64bu, L64bu, int, L64bu, L64b>* getBuffersSimulator() {
+		return &this->buffersSimulator;
+	}
+	/**
+	 * @brief Write the state of the buffers and the predictor model into a binary snapshot.
+	 *
+	 * It must be called after performing the experiment and before cleaning it.
+	 * @param os Output stream of the snapshot.
+	 */
+	void saveState(ostream& os);
+	/**
+	 * @brief Restore the state of the buffers and the predictor model from a binary snapshot written by saveState.
+	 *
+	 * The snapshot must come from an experiment with the same predictor parameters (e.g., the previous part
+	 * of the trace, or a shared warmed-up checkpoint). The model is not initialized when the experiment is performed.
+	 * @param is Input stream of the snapshot.
+	 */
+	void loadState(istream& is);
+	/**
+	 * @brief Check if the experiment covers the part of the trace that follows another experiment.
+	 * @param previous The other experiment.
+	 * @return True if both experiments are on the same trace and this one starts where the other ends.
+	 */
+	bool isContinuationOf(TracePredictExperiment* previous) {
+		return previous->traceFilename == this->traceFilename && previous->endLine == this->startLine;
+	}
 	/**
 	 * @brief Set the predictor model using a buffer simulator and SVM predictor.
 	 * @param bufferSimulator The buffer simulator.
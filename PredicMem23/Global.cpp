@@ -143,6 +143,181 @@ vector<PredictorParameters> decomposeDictionaryParametersBegin(vector<PredictorP
 	return decomposeDictionaryParameters(base, domain, params);
 }
 
+vector<PredictorParameters> decomposeModelParameters(vector<PredictorParameters>& base, ModelParametersDomain& domain, vector<string> params) {
+	string currentParam = params[0];
+	auto res = vector<PredictorParameters>();
+
+	// The experiments of the types that do not use the parameter are not repeated for each of its values:
+	auto used = vector<PredictorParameters>();
+	auto unused = vector<PredictorParameters>();
+	for (auto& predictorParams : base)
+		(usesModelParameter(predictorParams, currentParam) ? used : unused).push_back(predictorParams);
+
+	if (currentParam == "numBatchSamples") {
+		for (auto& value : domain.numBatchSamples) {
+			for (PredictorParameters predictorParams : used) {
+				predictorParams.modelParams.numBatchSamples = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "updateDelay") {
+		for (auto& value : domain.updateDelay) {
+			for (PredictorParameters predictorParams : used) {
+				predictorParams.modelParams.updateDelay = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "numShards") {
+		for (auto& value : domain.numShards) {
+			for (PredictorParameters predictorParams : used) {
+				predictorParams.modelParams.numShards = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "shardByCacheSet") {
+		for (auto value : domain.shardByCacheSet) {
+			for (PredictorParameters predictorParams : used) {
+				predictorParams.modelParams.shardByCacheSet = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "dfcmHashType") {
+		for (auto value : domain.dfcmHashType) {
+			for (PredictorParameters predictorParams : used) {
+				predictorParams.modelParams.dfcmHashType = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "numChooserIndexBits") {
+		for (auto value : domain.numChooserIndexBits) {
+			for (PredictorParameters predictorParams : used) {
+				predictorParams.modelParams.numChooserIndexBits = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "predictionDegree") {
+		for (auto value : domain.predictionDegree) {
+			for (PredictorParameters predictorParams : used) {
+				predictorParams.modelParams.predictionDegree = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "dfcmNumConfidenceBits") {
+		for (auto value : domain.dfcmNumConfidenceBits) {
+			for (PredictorParameters predictorParams : used) {
+				predictorParams.modelParams.dfcmNumConfidenceBits = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "dfcmConfidenceThreshold") {
+		for (auto value : domain.dfcmConfidenceThreshold) {
+			for (PredictorParameters predictorParams : used) {
+				predictorParams.modelParams.dfcmConfidenceThreshold = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else throw - 1;
+	res.insert(res.end(), unused.begin(), unused.end());
+
+	if (params.size() > 1) {
+		params.erase(params.begin());
+		res = decomposeModelParameters(res, domain, params);
+	}
+
+	return res;
+}
+
+
+vector<PredictorParameters> decomposeModelParametersBegin(vector<PredictorParameters>& base, ModelParametersDomain& domain) {
+	vector<string> params = vector<string>{ "numBatchSamples", "updateDelay", "numShards", "shardByCacheSet", "dfcmHashType",
+		"numChooserIndexBits", "predictionDegree", "dfcmNumConfidenceBits", "dfcmConfidenceThreshold" };
+	return decomposeModelParameters(base, domain, params);
+}
+
+vector<PredictorParameters> decomposePrefetchCacheParameters(vector<PredictorParameters>& base, PrefetchCacheParametersDomain& domain,
+	vector<string> params) {
+	string currentParam = params[0];
+	auto res = vector<PredictorParameters>();
+	if (currentParam == "numLineBits") {
+		for (auto value : domain.numLineBits) {
+			for (PredictorParameters predictorParams : base) {
+				predictorParams.prefetchCacheParams.numLineBits = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "numL1IndexBits") {
+		for (auto value : domain.numL1IndexBits) {
+			for (PredictorParameters predictorParams : base) {
+				predictorParams.prefetchCacheParams.numL1IndexBits = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "numL1Ways") {
+		for (auto value : domain.numL1Ways) {
+			for (PredictorParameters predictorParams : base) {
+				predictorParams.prefetchCacheParams.numL1Ways = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "numL2IndexBits") {
+		for (auto value : domain.numL2IndexBits) {
+			for (PredictorParameters predictorParams : base) {
+				predictorParams.prefetchCacheParams.numL2IndexBits = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "numL2Ways") {
+		for (auto value : domain.numL2Ways) {
+			for (PredictorParameters predictorParams : base) {
+				predictorParams.prefetchCacheParams.numL2Ways = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else if (currentParam == "prefetchLatency") {
+		for (auto value : domain.prefetchLatency) {
+			for (PredictorParameters predictorParams : base) {
+				predictorParams.prefetchCacheParams.prefetchLatency = value;
+				res.push_back(predictorParams);
+			}
+		}
+	}
+	else throw - 1;
+
+	if (params.size() > 1) {
+		params.erase(params.begin());
+		res = decomposePrefetchCacheParameters(res, domain, params);
+	}
+
+	return res;
+}
+
+
+vector<PredictorParameters> decomposePrefetchCacheParametersBegin(vector<PredictorParameters>& base,
+	PrefetchCacheParametersDomain& domain) {
+	// Without prefetch simulation, the cache parameters are not swept:
+	if (!domain.isSimulated)
+		return base;
+	for (auto& predictorParams : base)
+		predictorParams.prefetchCacheParams.isSimulated = true;
+	vector<string> params = vector<string>{ "numLineBits", "numL1IndexBits", "numL1Ways", "numL2IndexBits", "numL2Ways",
+		"prefetchLatency" };
+	return decomposePrefetchCacheParameters(base, domain, params);
+}
+
 vector<PredictorParameters> decomposePredictorParametersDomain(PredictorParametersDomain paramsDomain) {
 	vector<PredictorParameters> base = vector<PredictorParameters>();
 	for (auto& type : paramsDomain.types) {
@@ -154,6 +329,8 @@ vector<PredictorParameters> decomposePredictorParametersDomain(PredictorParamete
 	base = decomposeCacheParametersBegin(base, paramsDomain.cacheParams, false);
 	base = decomposeCacheParametersBegin(base, paramsDomain.additionalCacheParams, true);
 	base = decomposeDictionaryParametersBegin(base, paramsDomain.dictParams);
+	base = decomposeModelParametersBegin(base, paramsDomain.modelParams);
+	base = decomposePrefetchCacheParametersBegin(base, paramsDomain.prefetchCacheParams);
 
 	return base;
 }
@@ -221,6 +398,210 @@ DictionaryParametersDomain decodeDictionaryParametersDomain(TiXmlElement* elemen
 	return res;
 }
 
+ModelParametersDomain decodeModelParametersDomain(TiXmlElement* element) {
+	auto res = ModelParametersDomain();
+	res.numBatchSamples.clear();
+	res.updateDelay.clear();
+	res.numShards.clear();
+	res.shardByCacheSet.clear();
+	res.dfcmHashType.clear();
+	res.numChooserIndexBits.clear();
+	res.predictionDegree.clear();
+	res.dfcmNumConfidenceBits.clear();
+	res.dfcmConfidenceThreshold.clear();
+	for (TiXmlElement* child = element->FirstChildElement(); child != NULL; child = child->NextSiblingElement()) {
+		string childName = child->Value();
+		if (childName == "numBatchSamples") {
+			res.numBatchSamples.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "updateDelay") {
+			res.updateDelay.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "numShards") {
+			res.numShards.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "shardByCacheSet") {
+			res.shardByCacheSet.push_back((bool)std::stoi(child->GetText()));
+		}
+		else if (childName == "dfcmHashType") {
+			if (stringToDFCMHashTable.find(child->GetText()) == stringToDFCMHashTable.end()) {
+				string msg = string("ERROR: DFCM hash type ") + child->GetText() + string(" is not implemented!\n");
+				std::cout << msg;
+				throw std::invalid_argument(msg);
+			}
+			res.dfcmHashType.push_back(stringToDFCMHashTable[child->GetText()]);
+		}
+		else if (childName == "numChooserIndexBits") {
+			res.numChooserIndexBits.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "predictionDegree") {
+			res.predictionDegree.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "dfcmNumConfidenceBits") {
+			res.dfcmNumConfidenceBits.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "dfcmConfidenceThreshold") {
+			res.dfcmConfidenceThreshold.push_back(std::stoi(child->GetText()));
+		}
+	}
+
+	// The parameters that are not given keep their default (online training):
+	if (res.numBatchSamples.size() == 0) res.numBatchSamples.push_back(1);
+	if (res.updateDelay.size() == 0) res.updateDelay.push_back(0);
+	if (res.numShards.size() == 0) res.numShards.push_back(1);
+	if (res.shardByCacheSet.size() == 0) res.shardByCacheSet.push_back(false);
+	if (res.dfcmHashType.size() == 0) res.dfcmHashType.push_back(DFCMHashType::XorFold);
+	if (res.numChooserIndexBits.size() == 0) res.numChooserIndexBits.push_back(12);
+	if (res.predictionDegree.size() == 0) res.predictionDegree.push_back(1);
+	if (res.dfcmNumConfidenceBits.size() == 0) res.dfcmNumConfidenceBits.push_back(0);
+	if (res.dfcmConfidenceThreshold.size() == 0) res.dfcmConfidenceThreshold.push_back(1);
+
+	for (auto value : res.numBatchSamples) {
+		if (value < 1) {
+			string msg = "ERROR: The number of samples per mini-batch has to be greater than zero!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.updateDelay) {
+		if (value < 0) {
+			string msg = "ERROR: The update delay cannot be negative!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.numShards) {
+		if (value < 1) {
+			string msg = "ERROR: The number of shards has to be greater than zero!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.numChooserIndexBits) {
+		if (value < 0 || value > 30) {
+			string msg = "ERROR: The number of index bits of the chooser table has to be between 0 and 30!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.predictionDegree) {
+		if (value < 1) {
+			string msg = "ERROR: The prediction degree has to be greater than zero!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.dfcmNumConfidenceBits) {
+		if (value < 0 || value > 16) {
+			string msg = "ERROR: The number of bits of the DFCM confidence counters has to be between 0 and 16!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.dfcmConfidenceThreshold) {
+		if (value < 0) {
+			string msg = "ERROR: The DFCM confidence threshold cannot be negative!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	// Every threshold has to be reachable by the counters of every number of bits it is combined with:
+	for (auto numBits : res.dfcmNumConfidenceBits) {
+		for (auto value : res.dfcmConfidenceThreshold) {
+			if (numBits > 0 && value > (1 << numBits) - 1) {
+				string msg = "ERROR: The DFCM confidence threshold cannot be greater than the maximum confidence (2^dfcmNumConfidenceBits - 1)!\n";
+				std::cout << msg;
+				throw std::invalid_argument(msg);
+			}
+		}
+	}
+	return res;
+}
+
+PrefetchCacheParametersDomain decodePrefetchCacheParametersDomain(TiXmlElement* element) {
+	auto res = PrefetchCacheParametersDomain();
+	res.isSimulated = true;
+	res.numLineBits.clear();
+	res.numL1IndexBits.clear();
+	res.numL1Ways.clear();
+	res.numL2IndexBits.clear();
+	res.numL2Ways.clear();
+	res.prefetchLatency.clear();
+	for (TiXmlElement* child = element->FirstChildElement(); child != NULL; child = child->NextSiblingElement()) {
+		string childName = child->Value();
+		if (childName == "numLineBits") {
+			res.numLineBits.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "numL1IndexBits") {
+			res.numL1IndexBits.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "numL1Ways") {
+			res.numL1Ways.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "numL2IndexBits") {
+			res.numL2IndexBits.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "numL2Ways") {
+			res.numL2Ways.push_back(std::stoi(child->GetText()));
+		}
+		else if (childName == "prefetchLatency") {
+			res.prefetchLatency.push_back(std::stoi(child->GetText()));
+		}
+	}
+
+	// The parameters that are not given keep their default (32 KB L1 and 1 MB L2 of 64 B lines):
+	if (res.numLineBits.size() == 0) res.numLineBits.push_back(6);
+	if (res.numL1IndexBits.size() == 0) res.numL1IndexBits.push_back(6);
+	if (res.numL1Ways.size() == 0) res.numL1Ways.push_back(8);
+	if (res.numL2IndexBits.size() == 0) res.numL2IndexBits.push_back(10);
+	if (res.numL2Ways.size() == 0) res.numL2Ways.push_back(16);
+	if (res.prefetchLatency.size() == 0) res.prefetchLatency.push_back(10);
+
+	for (auto value : res.numLineBits) {
+		if (value < 0 || value > 20) {
+			string msg = "ERROR: The number of bits of the offset of a line has to be between 0 and 20!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.numL1IndexBits) {
+		if (value < 0 || value > 24) {
+			string msg = "ERROR: The number of index bits of the L1 has to be between 0 and 24!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.numL1Ways) {
+		if (value < 1) {
+			string msg = "ERROR: The number of ways of the L1 has to be greater than zero!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.numL2IndexBits) {
+		if (value < 0 || value > 24) {
+			string msg = "ERROR: The number of index bits of the L2 has to be between 0 and 24!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.numL2Ways) {
+		if (value < 0) {
+			string msg = "ERROR: The number of ways of the L2 cannot be negative!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	for (auto value : res.prefetchLatency) {
+		if (value < 0) {
+			string msg = "ERROR: The prefetch latency cannot be negative!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+	}
+	return res;
+}
+
 PredictorParametersDomain decodePredictorParametersDomain(TiXmlElement* element) {
 	auto res = PredictorParametersDomain();
 
@@ -243,6 +624,12 @@ PredictorParametersDomain decodePredictorParametersDomain(TiXmlElement* element)
 		else if (childName == "dictParams") {
 			res.dictParams = decodeDictionaryParametersDomain(child);
 		}
+		else if (childName == "modelParams") {
+			res.modelParams = decodeModelParametersDomain(child);
+		}
+		else if (childName == "prefetchCacheParams") {
+			res.prefetchCacheParams = decodePrefetchCacheParametersDomain(child);
+		}
 	}
 	
 	return res;
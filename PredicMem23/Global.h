@@ -7,24 +7,36 @@
 ///
 /// @details
 /// The following structures and functions are included:
+/// - DFCMHashType
 /// - ModelParameters
+/// - ModelParametersDomain
+/// - decodeModelParametersDomain
 /// - CacheParameters
 /// - CacheParametersDomain
 /// - decodeCacheParametersDomain
 /// - DictionaryParameters
 /// - DictionaryParametersDomain
 /// - decodeDictionaryParametersDomain
+/// - PrefetchCacheParameters
+/// - PrefetchCacheParametersDomain
+/// - decodePrefetchCacheParametersDomain
 /// - PredictorModelType
 /// - PredictorParameters
 /// - PredictorParametersDomain
 /// - decomposePredictorParametersDomain
+/// - LookaheadResults, LookaheadCounters, findNextInstructionAccesses
+/// - PrefetchResults
 /// - PredictResultsAndCosts
 /// - BuffersSVMPredictResultsAndCosts
+/// - HybridPredictResultsAndCosts
 /// - DFCMPredictResultsAndCosts
+/// - StridePredictResultsAndCosts
+/// - CorrelationPredictResultsAndCosts
 /// - TraceInfo
 /// - decodeTraceInfo
 /// - AccessesDataset
 /// - BuffersDataset
+/// - writeBinary, readBinary, writeBinaryVector, readBinaryVector
 ///
 /// @section LICENSE
 /// Copyright (c) 2024 Pablo Snchez Cuevas
@@ -55,6 +67,12 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <span>
+#include <limits>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
 #include <tinyxml.h>
 
 using namespace std;
@@ -64,13 +82,56 @@ using std::map;
 #define L64bu unsigned long long
 #define L64b long long
 
+/**
+ * @brief Hash functions of the order-K delta histories of KOrderDFCM.
+ *
+ * XorFold XORs the K deltas, ShiftXor shifts the previous deltas 1 bit before XORing the new one, and FSR5
+ * (fold-shift) folds each delta to the index bits of the second table and shifts the previous ones 5 bits.
+ */
+enum class DFCMHashType { XorFold, FSR5, ShiftXor };
+
+static map<string, DFCMHashType> stringToDFCMHashTable = {
+	{ "XorFold", DFCMHashType::XorFold },
+	{ "FSR5", DFCMHashType::FSR5 },
+	{ "ShiftXor", DFCMHashType::ShiftXor }
+};
+
 /**
  * @brief Structure to store model parameters.
  */
 struct ModelParameters {
+	int numBatchSamples = 1; ///< Number of mispredicted samples per training mini-batch (1 for online training).
+	int updateDelay = 0; ///< Number of accesses between the closing of a mini-batch and the update of the model.
+	int numShards = 1; ///< Number of shards (banks) with their own model (1 for a single shared model).
+	bool shardByCacheSet = false; ///< Whether the accesses are partitioned by cache set instead of by PC hash.
+	DFCMHashType dfcmHashType = DFCMHashType::XorFold; ///< Hash function of the delta histories of the K-order DFCM.
+	int numChooserIndexBits = 12; ///< Number of index bits of the per-PC chooser table of the hybrid predictors.
+	int predictionDegree = 1; ///< Number of accesses of each instruction predicted ahead by the SVMs and DFCMs.
+	int dfcmNumConfidenceBits = 0; ///< Number of bits of the confidence counters of the second table of the DFCMs (0 for none).
+	int dfcmConfidenceThreshold = 1; ///< Minimum confidence of a delta of the DFCMs to be predicted.
+};
 
+/**
+ * @brief Structure to store domain of model parameters.
+ */
+struct ModelParametersDomain {
+	vector<int> numBatchSamples = vector<int>{ 1 }; ///< Domain of number of samples per mini-batch.
+	vector<int> updateDelay = vector<int>{ 0 }; ///< Domain of update delay.
+	vector<int> numShards = vector<int>{ 1 }; ///< Domain of number of shards.
+	vector<bool> shardByCacheSet = vector<bool>{ false }; ///< Domain of shard by cache set flag.
+	vector<DFCMHashType> dfcmHashType = vector<DFCMHashType>{ DFCMHashType::XorFold }; ///< Domain of DFCM hash function.
+	vector<int> numChooserIndexBits = vector<int>{ 12 }; ///< Domain of number of index bits of the chooser table.
+	vector<int> predictionDegree = vector<int>{ 1 }; ///< Domain of prediction degree.
+	vector<int> dfcmNumConfidenceBits = vector<int>{ 0 }; ///< Domain of number of bits of the DFCM confidence counters.
+	vector<int> dfcmConfidenceThreshold = vector<int>{ 1 }; ///< Domain of DFCM confidence threshold.
 };
 
+/**
+*  @brief Decodification function from XML to ModelParametersDomain.
+* @param element XML element that contains the ModelParametersDomain
+*/
+ModelParametersDomain decodeModelParametersDomain(TiXmlElement* element);
+
 /**
  * @brief Structure to store cache parameters.
  */
@@ -125,16 +186,95 @@ struct DictionaryParametersDomain {
 */
 DictionaryParametersDomain decodeDictionaryParametersDomain(TiXmlElement* element);
 
+/**
+ * @brief Structure to store the parameters of the data caches fed with the predicted accesses as prefetches.
+ *
+ * The sizes are given in lines of 2^numLineBits bytes, and the latency of the prefetches in accesses of the trace.
+ */
+struct PrefetchCacheParameters {
+	bool isSimulated = false; ///< Whether the prefetches are simulated (only if the prefetchCacheParams are given).
+	int numLineBits = 6; ///< Number of bits of the offset of a line (64 B lines).
+	int numL1IndexBits = 6; ///< Number of index bits of the L1 data cache.
+	int numL1Ways = 8; ///< Number of ways of the L1 data cache.
+	int numL2IndexBits = 10; ///< Number of index bits of the L2 cache.
+	int numL2Ways = 16; ///< Number of ways of the L2 cache (0 for no L2).
+	int prefetchLatency = 10; ///< Number of accesses until a prefetched line arrives.
+};
+
+/**
+ * @brief Structure to store domain of prefetch cache parameters.
+ */
+struct PrefetchCacheParametersDomain {
+	bool isSimulated = false; ///< Whether the prefetches are simulated.
+	vector<int> numLineBits = vector<int>{ 6 }; ///< Domain of number of bits of the offset of a line.
+	vector<int> numL1IndexBits = vector<int>{ 6 }; ///< Domain of number of index bits of the L1 data cache.
+	vector<int> numL1Ways = vector<int>{ 8 }; ///< Domain of number of ways of the L1 data cache.
+	vector<int> numL2IndexBits = vector<int>{ 10 }; ///< Domain of number of index bits of the L2 cache.
+	vector<int> numL2Ways = vector<int>{ 16 }; ///< Domain of number of ways of the L2 cache.
+	vector<int> prefetchLatency = vector<int>{ 10 }; ///< Domain of prefetch latency.
+};
+
+/**
+*  @brief Decodification function from XML to PrefetchCacheParametersDomain.
+* @param element XML element that contains the PrefetchCacheParametersDomain
+*/
+PrefetchCacheParametersDomain decodePrefetchCacheParametersDomain(TiXmlElement* element);
+
 /**
  * @brief Enum class for predictor model types.
+ *
+ * BufferSVM computes with float32 weights, as costed in the memory of the model, while BufferSVMDouble keeps the
+ * double weights of the reference software model, and BufferSVMInt16 and BufferSVMInt8 use fixed-point weights.
+ * BufferSVMOneHot and BufferSVMHashed (float32) encode the history as sparse binary features instead of scaled classes.
+ * Stride (with confidence) and TwoDeltaStride are the classic PC-indexed stride baselines, and DCPT (delta-correlating
+ * prediction tables) and GHB (PC-localized global history buffer) are the delta-correlation baselines.
+ * HybridSVMDFCM runs a BufferSVM and a KOrderDFCM over the same accesses, and a per-PC chooser picks the prediction.
  */
-enum class PredictorModelType { BufferSVM, DFCM };
+enum class PredictorModelType { BufferSVM, DFCM, BufferSVMDouble, BufferSVMInt16, BufferSVMInt8, BufferSVMOneHot,
+	BufferSVMHashed, Stride, TwoDeltaStride, DCPT, GHB, HybridSVMDFCM };
 
 static map<string, PredictorModelType> stringToPredictorTable = { 
 	{ "BufferSVM", PredictorModelType::BufferSVM },
-	{ "DFCM", PredictorModelType::DFCM}
+	{ "DFCM", PredictorModelType::DFCM},
+	{ "BufferSVMDouble", PredictorModelType::BufferSVMDouble },
+	{ "BufferSVMInt16", PredictorModelType::BufferSVMInt16 },
+	{ "BufferSVMInt8", PredictorModelType::BufferSVMInt8 },
+	{ "BufferSVMOneHot", PredictorModelType::BufferSVMOneHot },
+	{ "BufferSVMHashed", PredictorModelType::BufferSVMHashed },
+	{ "Stride", PredictorModelType::Stride },
+	{ "TwoDeltaStride", PredictorModelType::TwoDeltaStride },
+	{ "DCPT", PredictorModelType::DCPT },
+	{ "GHB", PredictorModelType::GHB },
+	{ "HybridSVMDFCM", PredictorModelType::HybridSVMDFCM }
 };
 
+/**
+ * @brief Check if a predictor model type is one of the stride baselines.
+ * @param type Predictor model type.
+ * @return True if the model is a stride predictor.
+ */
+inline bool isStridePredictor(PredictorModelType type) {
+	return type == PredictorModelType::Stride || type == PredictorModelType::TwoDeltaStride;
+}
+
+/**
+ * @brief Check if a predictor model type is one of the delta-correlation baselines.
+ * @param type Predictor model type.
+ * @return True if the model is a correlation predictor.
+ */
+inline bool isCorrelationPredictor(PredictorModelType type) {
+	return type == PredictorModelType::DCPT || type == PredictorModelType::GHB;
+}
+
+/**
+ * @brief Check if a predictor model type is an SVM over simulated buffers (with any backend of weights, or in a hybrid).
+ * @param type Predictor model type.
+ * @return True if the model uses the buffers simulator.
+ */
+inline bool isBufferSVM(PredictorModelType type) {
+	return type != PredictorModelType::DFCM && !isStridePredictor(type) && !isCorrelationPredictor(type);
+}
+
 /**
  * @brief Structure to store predictor parameters.
  */
@@ -143,8 +283,33 @@ struct PredictorParameters {
 	CacheParameters cacheParams; ///< Cache parameters.
 	CacheParameters additionalCacheParams; ///< Additional cache parameters.
 	DictionaryParameters dictParams; ///< Dictionary parameters.
+	ModelParameters modelParams; ///< Model (training) parameters.
+	PrefetchCacheParameters prefetchCacheParams; ///< Parameters of the data caches fed with the prefetches.
 };
 
+/**
+ * @brief Check if a predictor model uses a model parameter, so that the sweep only repeats its experiments for the
+ * values of the parameters that change them.
+ * @param params Predictor parameters (the type, and the cache parameters that select the variant of the DFCM).
+ * @param param Name of the model parameter, as in the input XML file.
+ * @return True if the parameter affects the model.
+ */
+inline bool usesModelParameter(const PredictorParameters& params, const string& param) {
+	if (param == "numBatchSamples" || param == "updateDelay" || param == "numShards" || param == "shardByCacheSet")
+		return isBufferSVM(params.type);
+	if (param == "predictionDegree")
+		return params.type == PredictorModelType::DFCM ||
+			(isBufferSVM(params.type) && params.type != PredictorModelType::HybridSVMDFCM);
+	if (param == "numChooserIndexBits")
+		return params.type == PredictorModelType::HybridSVMDFCM;
+	// The hash function is only used by the K-order DFCM (the DFCM with numSequenceAccesses, and the one of the hybrid):
+	if (param == "dfcmHashType")
+		return params.type == PredictorModelType::HybridSVMDFCM ||
+			(params.type == PredictorModelType::DFCM && params.cacheParams.numSequenceAccesses > 0);
+	// dfcmNumConfidenceBits and dfcmConfidenceThreshold:
+	return params.type == PredictorModelType::DFCM || params.type == PredictorModelType::HybridSVMDFCM;
+}
+
 /**
  * @brief Structure to store domain of predictor parameters.
  */
@@ -153,6 +318,8 @@ struct PredictorParametersDomain {
 	CacheParametersDomain cacheParams; ///< Domain of cache parameters.
 	CacheParametersDomain additionalCacheParams; ///< Domain of additional cache parameters.
 	DictionaryParametersDomain dictParams; ///< Domain of dictionary parameters.
+	ModelParametersDomain modelParams; ///< Domain of model (training) parameters.
+	PrefetchCacheParametersDomain prefetchCacheParams; ///< Domain of prefetch cache parameters.
 };
 
 /**
@@ -169,6 +336,159 @@ PredictorParametersDomain decodePredictorParametersDomain(TiXmlElement* element)
  */
 vector<PredictorParameters> decomposePredictorParametersDomain(PredictorParametersDomain paramsDomain);
 
+/**
+ * @brief Rates of the predictions of several accesses ahead, per depth (from 1 to the prediction degree).
+ */
+struct LookaheadResults {
+	vector<double> hitRates = vector<double>(); ///< Correct predictions of each depth over all the accesses.
+	vector<double> coverages = vector<double>(); ///< Predictions of each depth issued over all the accesses.
+	vector<double> accuracies = vector<double>(); ///< Correct predictions of each depth over the issued ones.
+
+	/**
+	 * @brief Add the rates of every depth to a map of results (only if more than one access is predicted ahead).
+	 * @param res The map of results.
+	 */
+	void addTo(map<string, double>& res) const {
+		if (hitRates.size() <= 1)
+			return;
+		for (size_t d = 0; d < hitRates.size(); d++) {
+			string depth = "depth" + to_string(d + 1);
+			res[depth + "HitRate"] = hitRates[d];
+			res[depth + "Coverage"] = coverages[d];
+			res[depth + "Accuracy"] = accuracies[d];
+		}
+	}
+};
+
+/**
+ * @brief Counters of the predictions of several accesses ahead, per depth.
+ *
+ * The prediction of depth d made at an access is scored against the access d - 1 places after it among the accesses
+ * of its instruction (see findNextInstructionAccesses), so every access is scored against the window of the next
+ * accesses of its instruction in a single pass.
+ */
+struct LookaheadCounters {
+	vector<long> numPredictions = vector<long>(); ///< Number of predictions issued of each depth.
+	vector<long> numHits = vector<long>(); ///< Number of correct predictions of each depth.
+
+	/**
+	 * @brief Constructor.
+	 * @param degree Number of depths.
+	 */
+	LookaheadCounters(int degree = 0) {
+		this->numPredictions = vector<long>(degree, 0);
+		this->numHits = vector<long>(degree, 0);
+	}
+
+	/**
+	 * @brief Accumulate the counters of another set of accesses (e.g. of another shard).
+	 * @param other The other counters, with the same degree.
+	 */
+	void add(const LookaheadCounters& other) {
+		for (size_t d = 0; d < this->numPredictions.size(); d++) {
+			this->numPredictions[d] += other.numPredictions[d];
+			this->numHits[d] += other.numHits[d];
+		}
+	}
+
+	/**
+	 * @brief Score the predictions of several accesses ahead made at an access.
+	 * @tparam A Type of access.
+	 * @param i Index of the access.
+	 * @param predictedAccesses Predicted accesses, from depth 1 on.
+	 * @param numPredicted Number of predicted accesses (the depths after them are not issued).
+	 * @param accesses All the accesses.
+	 * @param nextAccesses Next access of the same instruction of every access (see findNextInstructionAccesses).
+	 */
+	template<typename A>
+	void score(int i, const A* predictedAccesses, int numPredicted, const vector<A>& accesses, const vector<int>& nextAccesses) {
+		for (int d = 0, j = i; d < numPredicted; d++) {
+			this->numPredictions[d]++;
+			if (j >= 0 && accesses[j] == predictedAccesses[d])
+				this->numHits[d]++;
+			j = j >= 0 ? nextAccesses[j] : -1;
+		}
+	}
+
+	/**
+	 * @brief Get the rates of every depth.
+	 * @param numAccesses Number of simulated accesses.
+	 * @return The rates.
+	 */
+	LookaheadResults getResults(size_t numAccesses) const {
+		LookaheadResults res;
+		for (size_t d = 0; d < this->numPredictions.size(); d++) {
+			res.hitRates.push_back(numAccesses > 0 ? (double)this->numHits[d] / numAccesses : 0.0);
+			res.coverages.push_back(numAccesses > 0 ? (double)this->numPredictions[d] / numAccesses : 0.0);
+			res.accuracies.push_back(this->numPredictions[d] > 0 ? (double)this->numHits[d] / this->numPredictions[d] : 0.0);
+		}
+		return res;
+	}
+};
+
+/**
+ * @brief Find the next access of the same instruction of every access.
+ * @tparam I Type of instruction.
+ * @param instructions Instructions of the accesses.
+ * @return Index of the next access of the same instruction of every access (-1 if there is none).
+ */
+template<typename I>
+vector<int> findNextInstructionAccesses(const vector<I>& instructions) {
+	vector<int> res = vector<int>(instructions.size(), -1);
+	unordered_map<I, int> nextAccesses;
+	for (int i = (int)instructions.size() - 1; i >= 0; i--) {
+		auto [iter, isNew] = nextAccesses.try_emplace(instructions[i], i);
+		if (!isNew) {
+			res[i] = iter->second;
+			iter->second = i;
+		}
+	}
+	return res;
+}
+
+/**
+ * @brief Effect of the predicted accesses issued as prefetches into the data caches (see PrefetchCacheSimulator).
+ *
+ * The miss rates are over all the accesses, and the prefetch rates over the issued prefetches, except prefetchRate.
+ */
+struct PrefetchResults {
+	bool isSimulated = false; ///< Whether the prefetches were simulated.
+	bool isL2Simulated = false; ///< Whether the data caches have an L2.
+	double l1MissRate = 0.0; ///< Miss rate of the L1 with the prefetches.
+	double baselineL1MissRate = 0.0; ///< Miss rate of the L1 without prefetches.
+	double l1MissReduction = 0.0; ///< Fraction of the L1 misses without prefetches removed by them.
+	double l2MissRate = 0.0; ///< Miss rate of the L2 (over all the accesses) with the prefetches.
+	double baselineL2MissRate = 0.0; ///< Miss rate of the L2 (over all the accesses) without prefetches.
+	double l2MissReduction = 0.0; ///< Fraction of the L2 misses without prefetches removed by them.
+	double prefetchRate = 0.0; ///< Prefetches issued over all the accesses.
+	double usefulPrefetchRate = 0.0; ///< Prefetched lines demanded after their arrival.
+	double latePrefetchRate = 0.0; ///< Prefetched lines demanded while still in flight.
+	double uselessPrefetchRate = 0.0; ///< Prefetched lines evicted from the L1 before being demanded.
+	double pollutingPrefetchRate = 0.0; ///< L1 misses caused by the prefetches (lines the L1 without prefetches keeps).
+
+	/**
+	 * @brief Add the rates to a map of results (only if the prefetches were simulated).
+	 * @param res The map of results.
+	 */
+	void addTo(map<string, double>& res) const {
+		if (!isSimulated)
+			return;
+		res["l1MissRate"] = l1MissRate;
+		res["baselineL1MissRate"] = baselineL1MissRate;
+		res["l1MissReduction"] = l1MissReduction;
+		if (isL2Simulated) {
+			res["l2MissRate"] = l2MissRate;
+			res["baselineL2MissRate"] = baselineL2MissRate;
+			res["l2MissReduction"] = l2MissReduction;
+		}
+		res["prefetchRate"] = prefetchRate;
+		res["usefulPrefetchRate"] = usefulPrefetchRate;
+		res["latePrefetchRate"] = latePrefetchRate;
+		res["uselessPrefetchRate"] = uselessPrefetchRate;
+		res["pollutingPrefetchRate"] = pollutingPrefetchRate;
+	}
+};
+
 /**
  * @brief Abstract class for prediction results and costs.
  */
@@ -213,6 +533,10 @@ public:
 	double dictionaryMemoryCost = 0.0; ///< Dictionary memory cost.
 	double modelMemoryCost = 0.0; ///< Model memory cost.
 	double totalMemoryCost = 0.0; ///< Total memory cost.
+	int numShards = 1; ///< Number of shards of the predictor (1 if not sharded).
+	double sequentialHitRate = 0.0; ///< Hit rate of a single shared model (only for sharded predictors).
+	LookaheadResults lookahead; ///< Rates of the predictions of several accesses ahead (if the prediction degree is over 1).
+	PrefetchResults prefetch; ///< Effect of the predictions issued as prefetches (if they are simulated).
 
 	/**
 	 * @brief Default constructor.
@@ -265,7 +589,7 @@ public:
 	 * @return A map of results and costs.
 	 */
 	map<string, double> getResultsAndCosts() {
-		return {
+		map<string, double> res = {
 			{"hitRate", hitRate},
 			{"cacheMissRate", cacheMissRate},
 			{"dictionaryMissRate", dictionaryMissRate},
@@ -274,21 +598,70 @@ public:
 			{"modelMemoryCost", modelMemoryCost},
 			{"totalMemoryCost", totalMemoryCost},
 		};
+
+		// The sharded predictors are reported alongside their sequential baseline:
+		if (numShards > 1) {
+			res["numShards"] = numShards;
+			res["sequentialHitRate"] = sequentialHitRate;
+		}
+		lookahead.addTo(res);
+		prefetch.addTo(res);
+		return res;
 	}
 };
 
 
+/**
+ * @brief Class for the prediction results and costs of the hybrid of a BufferSVM and a DFCM.
+ *
+ * The hit rate is the one of the predictions picked by the chooser, and the model memory cost adds the SVM, the
+ * DFCM tables and the chooser table, so that the buffers are costed as for a BufferSVM.
+ */
+class HybridPredictResultsAndCosts : public BuffersSVMPredictResultsAndCosts {
+public:
+	double svmHitRate = 0.0; ///< Hit rate of the SVM alone.
+	double dfcmHitRate = 0.0; ///< Hit rate of the DFCM alone.
+	double dfcmChoiceRate = 0.0; ///< Fraction of the accesses for which the chooser picks the DFCM.
+	double svmModelMemoryCost = 0.0; ///< Memory cost of the SVM model.
+	double dfcmMemoryCost = 0.0; ///< Memory cost of the DFCM tables.
+	double chooserMemoryCost = 0.0; ///< Memory cost of the chooser table.
+
+	/**
+	 * @brief Default constructor.
+	 */
+	HybridPredictResultsAndCosts() {}
+
+	/**
+	 * @brief Get the results and costs as a map.
+	 * @return A map of results and costs.
+	 */
+	map<string, double> getResultsAndCosts() {
+		map<string, double> res = BuffersSVMPredictResultsAndCosts::getResultsAndCosts();
+		res["svmHitRate"] = svmHitRate;
+		res["dfcmHitRate"] = dfcmHitRate;
+		res["dfcmChoiceRate"] = dfcmChoiceRate;
+		res["svmModelMemoryCost"] = svmModelMemoryCost;
+		res["dfcmMemoryCost"] = dfcmMemoryCost;
+		res["chooserMemoryCost"] = chooserMemoryCost;
+		return res;
+	}
+};
+
 /**
  * @brief Class for DFCM prediction results and costs.
  */
 class DFCMPredictResultsAndCosts : PredictResultsAndCosts {
 public:
 	double hitRate = 0.0; ///< Hit rate.
+	double coverage = 0.0; ///< Fraction of the accesses for which a prediction is issued.
+	double accuracy = 0.0; ///< Fraction of the issued predictions that are correct.
 	double firstTableMissRate = 0.0; ///< First table miss rate.
 	double secondTableMissRate = 0.0; ///< Second table miss rate.
 	double firstTableMemoryCost = 0.0; ///< First table memory cost.
 	double secondTableMemoryCost = 0.0; ///< Second table memory cost.
 	double totalMemoryCost = 0.0; ///< Total memory cost.
+	LookaheadResults lookahead; ///< Rates of the predictions of several accesses ahead (if the prediction degree is over 1).
+	PrefetchResults prefetch; ///< Effect of the predictions issued as prefetches (if they are simulated).
 
 	/**
 	 * @brief Default constructor.
@@ -339,14 +712,133 @@ public:
 	 * @return A map of results and costs.
 	 */
 	map<string, double> getResultsAndCosts() {
-		return {
+		map<string, double> res = {
 			{"hitRate", hitRate},
+			{"coverage", coverage},
+			{"accuracy", accuracy},
 			{"firstTableMissRate", firstTableMissRate},
 			{"secondTableMissRate", secondTableMissRate},
 			{"firstTableMemoryCost", firstTableMemoryCost},
 			{"secondTableMemoryCost", secondTableMemoryCost},
 			{"totalMemoryCost", totalMemoryCost},
 		};
+		lookahead.addTo(res);
+		prefetch.addTo(res);
+		return res;
+	}
+};
+
+/**
+ * @brief Class for stride prediction results and costs.
+ */
+class StridePredictResultsAndCosts : PredictResultsAndCosts {
+public:
+	double hitRate = 0.0; ///< Hit rate (correct predictions over all the accesses).
+	double coverage = 0.0; ///< Fraction of the accesses for which a prediction is issued.
+	double accuracy = 0.0; ///< Fraction of the issued predictions that are correct.
+	double tableMissRate = 0.0; ///< Miss rate of the stride table.
+	double totalMemoryCost = 0.0; ///< Total memory cost.
+	PrefetchResults prefetch; ///< Effect of the predictions issued as prefetches (if they are simulated).
+
+	/**
+	 * @brief Default constructor.
+	 */
+	StridePredictResultsAndCosts() {}
+
+	/**
+	* @brief Get the hit rate.
+	* @return The hit rate.
+	*/
+	double getHitRate() { return hitRate; }
+	/**
+	 * @brief Set the hit rate.
+	 * @param hitRate The hit rate to set.
+	 */
+	void setHitRate(double hitRate) { this->hitRate = hitRate; }
+	/**
+	 * @brief Get the total memory cost.
+	 * @return The total memory cost.
+	 */
+	double getTotalMemoryCost() { return totalMemoryCost; }
+	/**
+	 * @brief Set the total memory cost.
+	 * @param totalMemoryCost The total memory cost to set.
+	 */
+	void setTotalMemoryCost(double totalMemoryCost) { this->totalMemoryCost = totalMemoryCost; }
+
+	/**
+	 * @brief Get the results and costs as a map.
+	 * @return A map of results and costs.
+	 */
+	map<string, double> getResultsAndCosts() {
+		map<string, double> res = {
+			{"hitRate", hitRate},
+			{"coverage", coverage},
+			{"accuracy", accuracy},
+			{"tableMissRate", tableMissRate},
+			{"totalMemoryCost", totalMemoryCost},
+		};
+		prefetch.addTo(res);
+		return res;
+	}
+};
+
+/**
+ * @brief Class for delta-correlation prediction results and costs.
+ */
+class CorrelationPredictResultsAndCosts : PredictResultsAndCosts {
+public:
+	double hitRate = 0.0; ///< Hit rate (correct predictions over all the accesses).
+	double coverage = 0.0; ///< Fraction of the accesses for which a prediction is issued.
+	double accuracy = 0.0; ///< Fraction of the issued predictions that are correct.
+	double tableMissRate = 0.0; ///< Miss rate of the instruction table.
+	double tableMemoryCost = 0.0; ///< Memory cost of the instruction table.
+	double historyBufferMemoryCost = 0.0; ///< Memory cost of the global history buffer (0 for DCPT).
+	double totalMemoryCost = 0.0; ///< Total memory cost.
+	PrefetchResults prefetch; ///< Effect of the predictions issued as prefetches (if they are simulated).
+
+	/**
+	 * @brief Default constructor.
+	 */
+	CorrelationPredictResultsAndCosts() {}
+
+	/**
+	* @brief Get the hit rate.
+	* @return The hit rate.
+	*/
+	double getHitRate() { return hitRate; }
+	/**
+	 * @brief Set the hit rate.
+	 * @param hitRate The hit rate to set.
+	 */
+	void setHitRate(double hitRate) { this->hitRate = hitRate; }
+	/**
+	 * @brief Get the total memory cost.
+	 * @return The total memory cost.
+	 */
+	double getTotalMemoryCost() { return totalMemoryCost; }
+	/**
+	 * @brief Set the total memory cost.
+	 * @param totalMemoryCost The total memory cost to set.
+	 */
+	void setTotalMemoryCost(double totalMemoryCost) { this->totalMemoryCost = totalMemoryCost; }
+
+	/**
+	 * @brief Get the results and costs as a map.
+	 * @return A map of results and costs.
+	 */
+	map<string, double> getResultsAndCosts() {
+		map<string, double> res = {
+			{"hitRate", hitRate},
+			{"coverage", coverage},
+			{"accuracy", accuracy},
+			{"tableMissRate", tableMissRate},
+			{"tableMemoryCost", tableMemoryCost},
+			{"historyBufferMemoryCost", historyBufferMemoryCost},
+			{"totalMemoryCost", totalMemoryCost},
+		};
+		prefetch.addTo(res);
+		return res;
 	}
 };
 
@@ -377,15 +869,287 @@ struct AccessesDataset {
 	vector<I> accessesInstructions = vector<I>(); ///< Vector of access instructions.
 };
 
+/**
+ * @brief Assignment of a delta to a class of the dictionary, made by an access of a buffers dataset.
+ * @tparam A Type of the classes.
+ */
+template<typename A>
+struct ClassDeltaUpdate {
+	long access; ///< Index of the access that assigns the delta (-1 for the dictionary before the first access).
+	A class_; ///< The class.
+	L64b delta; ///< The delta assigned to the class.
+};
+
 /**
  * @brief Template structure to store buffers dataset.
+ *
+ * The input accesses are stored in a single contiguous row-major buffer of
+ * numAccesses x numSequenceAccesses classes, where the invalid class (-1) is
+ * stored as the maximum value of the stored type. The classes are stored as
+ * unsigned char when there are fewer than 255 of them (so that the invalid
+ * class also fits), and as unsigned short otherwise. The cache miss, dictionary
+ * miss and validity flags of each access are packed in one byte.
+ *
+ * To prefetch the predicted accesses, the dataset can also record the last
+ * access of the instruction of every access (the base of its delta), and the
+ * log of the deltas assigned to the classes by the dictionary, so that the
+ * delta of a predicted class is known as of any access.
  * @tparam A Type of access.
  */
 template<typename A = long>
 struct BuffersDataset {
-	vector<vector<A>> inputAccesses = vector<vector<A>>(); ///< Vector of input accesses.
+	static constexpr unsigned char CACHE_MISS_FLAG = 1; ///< Flag bit of a cache miss.
+	static constexpr unsigned char DICTIONARY_MISS_FLAG = 2; ///< Flag bit of a dictionary miss.
+	static constexpr unsigned char VALID_FLAG = 4; ///< Flag bit of a valid access.
+
+	int numSequenceAccesses = 0; ///< Number of input accesses per row.
+	bool hasWideClasses = false; ///< Whether the input classes are stored as unsigned short.
+	vector<unsigned char> inputAccesses = vector<unsigned char>(); ///< Row-major buffer of narrow input accesses.
+	vector<unsigned short> wideInputAccesses = vector<unsigned short>(); ///< Row-major buffer of wide input accesses.
 	vector<A> outputAccesses = vector<A>(); ///< Vector of output accesses.
-	vector<bool> isCacheMiss = vector<bool>(); ///< Vector indicating cache misses.
-	vector<bool> isDictionaryMiss = vector<bool>(); ///< Vector indicating dictionary misses.
-	vector<bool> isValid = vector<bool>(); ///< Vector indicating validity.
+	vector<unsigned char> flags = vector<unsigned char>(); ///< Packed flags of every access.
+	bool recordsLastAccesses = false; ///< Whether the last accesses and the deltas of the classes are recorded.
+	vector<L64bu> lastAccesses = vector<L64bu>(); ///< Last access of the instruction of every access (if recorded).
+	vector<ClassDeltaUpdate<A>> classDeltaUpdates = vector<ClassDeltaUpdate<A>>(); ///< Log of the deltas assigned to the classes, in order (if recorded).
+
+	/**
+	 * @brief Default constructor.
+	 */
+	BuffersDataset() {}
+
+	/**
+	 * @brief Constructor with the length of the rows and the number of classes, which selects the stored type.
+	 * @param numSequenceAccesses Number of input accesses per row.
+	 * @param numClasses Number of classes (besides the invalid one) of the input accesses.
+	 * @param recordsLastAccesses Whether the last accesses and the deltas of the classes are recorded.
+	 */
+	BuffersDataset(int numSequenceAccesses, int numClasses, bool recordsLastAccesses = false) {
+		if (!canStoreClasses<unsigned short>(numClasses)) {
+			string msg = "ERROR: The number of classes is too big to be stored in the buffers dataset!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
+		this->numSequenceAccesses = numSequenceAccesses;
+		this->hasWideClasses = !canStoreClasses<unsigned char>(numClasses);
+		this->recordsLastAccesses = recordsLastAccesses;
+	}
+
+	/**
+	 * @brief Check if classes from 0 to numClasses (both included) can be stored in a type.
+	 * @tparam C Type of the stored classes.
+	 * @param numClasses Number of classes.
+	 * @return True if every class fits in C, false otherwise.
+	 */
+	template<typename C>
+	static bool canStoreClasses(int numClasses) {
+		return numClasses >= 0 && (unsigned long long)numClasses < (unsigned long long)std::numeric_limits<C>::max();
+	}
+
+	/**
+	 * @brief Encode a class to be stored.
+	 * @tparam C Type of the stored classes.
+	 * @param class_ The class to encode.
+	 * @return The stored value.
+	 */
+	template<typename C>
+	static C encodeClass(A class_) {
+		return class_ < 0 ? std::numeric_limits<C>::max() : (C)class_;
+	}
+
+	/**
+	 * @brief Decode a stored class.
+	 * @tparam C Type of the stored classes.
+	 * @param class_ The stored value.
+	 * @return The class.
+	 */
+	template<typename C>
+	static A decodeClass(C class_) {
+		return class_ == std::numeric_limits<C>::max() ? -1 : (A)class_;
+	}
+
+	/**
+	 * @brief Get the number of accesses.
+	 * @return The number of accesses.
+	 */
+	size_t size() const {
+		return outputAccesses.size();
+	}
+
+	/**
+	 * @brief Reserve memory for a number of accesses.
+	 * @param numAccesses The number of accesses.
+	 */
+	void reserve(size_t numAccesses) {
+		if (hasWideClasses)
+			wideInputAccesses.reserve(numAccesses * numSequenceAccesses);
+		else
+			inputAccesses.reserve(numAccesses * numSequenceAccesses);
+		outputAccesses.reserve(numAccesses);
+		flags.reserve(numAccesses);
+		if (recordsLastAccesses)
+			lastAccesses.reserve(numAccesses);
+	}
+
+	/**
+	 * @brief Append a new access, whose input row is initialized with invalid classes (see setInputAccess).
+	 * @param outputAccess The output access.
+	 * @param isCacheMiss Whether there was a cache miss.
+	 * @param isDictionaryMiss Whether there was a dictionary miss.
+	 * @param isValid Whether the access is valid.
+	 * @param lastAccess Last access of the instruction (the access itself after a cache miss), if recorded.
+	 */
+	void push_back(A outputAccess, bool isCacheMiss, bool isDictionaryMiss, bool isValid, L64bu lastAccess = 0) {
+		outputAccesses.push_back(outputAccess);
+		if (recordsLastAccesses)
+			lastAccesses.push_back(lastAccess);
+		flags.push_back((isCacheMiss ? CACHE_MISS_FLAG : 0) | (isDictionaryMiss ? DICTIONARY_MISS_FLAG : 0)
+			| (isValid ? VALID_FLAG : 0));
+		if (hasWideClasses)
+			wideInputAccesses.resize(wideInputAccesses.size() + numSequenceAccesses, std::numeric_limits<unsigned short>::max());
+		else
+			inputAccesses.resize(inputAccesses.size() + numSequenceAccesses, std::numeric_limits<unsigned char>::max());
+	}
+
+	/**
+	 * @brief Record that the dictionary assigns a delta to a class (if the deltas of the classes are recorded).
+	 * @param access Index of the access that assigns it (-1 for the dictionary before the first access).
+	 * @param class_ The class.
+	 * @param delta The delta.
+	 */
+	void recordClassDelta(long access, A class_, L64b delta) {
+		if (recordsLastAccesses)
+			classDeltaUpdates.push_back({ access, class_, delta });
+	}
+
+	/**
+	 * @brief Set one input class of an access.
+	 * @param i Index of the access.
+	 * @param j Position in the input row.
+	 * @param class_ The input class (-1 if invalid).
+	 */
+	void setInputAccess(size_t i, int j, A class_) {
+		if (hasWideClasses)
+			wideInputAccesses[i * numSequenceAccesses + j] = encodeClass<unsigned short>(class_);
+		else
+			inputAccesses[i * numSequenceAccesses + j] = encodeClass<unsigned char>(class_);
+	}
+
+	/**
+	 * @brief Visit the stored input row of an access, with the span of its stored type.
+	 *
+	 * The visitor is instantiated for both stored types, and receives the encoded classes (see decodeClass).
+	 *
+	 * @tparam F Type of the visitor.
+	 * @param i Index of the access.
+	 * @param visitor Callable with a span<const unsigned char> or a span<const unsigned short>.
+	 * @return The result of the visitor.
+	 */
+	template<typename F>
+	auto visitInputAccesses(size_t i, F visitor) const {
+		if (hasWideClasses)
+			return visitor(span<const unsigned short>(wideInputAccesses.data() + i * numSequenceAccesses, numSequenceAccesses));
+		return visitor(span<const unsigned char>(inputAccesses.data() + i * numSequenceAccesses, numSequenceAccesses));
+	}
+
+	/**
+	 * @brief Get one decoded input class of an access.
+	 * @param i Index of the access.
+	 * @param j Position in the input row.
+	 * @return The input class.
+	 */
+	A getInputAccess(size_t i, int j) const {
+		if (hasWideClasses)
+			return decodeClass(wideInputAccesses[i * numSequenceAccesses + j]);
+		return decodeClass(inputAccesses[i * numSequenceAccesses + j]);
+	}
+
+	/**
+	 * @brief Check if an access was a cache miss.
+	 * @param i Index of the access.
+	 * @return True if it was a cache miss, false otherwise.
+	 */
+	bool isCacheMiss(size_t i) const {
+		return flags[i] & CACHE_MISS_FLAG;
+	}
+
+	/**
+	 * @brief Check if an access was a dictionary miss.
+	 * @param i Index of the access.
+	 * @return True if it was a dictionary miss, false otherwise.
+	 */
+	bool isDictionaryMiss(size_t i) const {
+		return flags[i] & DICTIONARY_MISS_FLAG;
+	}
+
+	/**
+	 * @brief Check if an access is valid.
+	 * @param i Index of the access.
+	 * @return True if it is valid, false otherwise.
+	 */
+	bool isValid(size_t i) const {
+		return flags[i] & VALID_FLAG;
+	}
 };
+
+
+/**
+ * @brief Write a trivially copyable value into a binary snapshot.
+ * @tparam V Type of the value.
+ * @param os Output stream of the snapshot.
+ * @param value The value to write.
+ */
+template<typename V>
+void writeBinary(ostream& os, const V& value) {
+	static_assert(std::is_trivially_copyable<V>::value, "Type is not trivially copyable");
+	os.write((const char*)&value, sizeof(V));
+}
+
+/**
+ * @brief Read a trivially copyable value from a binary snapshot.
+ * @tparam V Type of the value.
+ * @param is Input stream of the snapshot.
+ * @param value The value to read.
+ */
+template<typename V>
+void readBinary(istream& is, V& value) {
+	static_assert(std::is_trivially_copyable<V>::value, "Type is not trivially copyable");
+	is.read((char*)&value, sizeof(V));
+	if (!is) {
+		string msg = "ERROR: The snapshot is truncated or corrupted!\n";
+		std::cout << msg;
+		throw std::invalid_argument(msg);
+	}
+}
+
+/**
+ * @brief Write a vector of trivially copyable values (preceded by its size) into a binary snapshot.
+ * @tparam V Type of the values.
+ * @param os Output stream of the snapshot.
+ * @param values The values to write.
+ */
+template<typename V, typename Alloc>
+void writeBinaryVector(ostream& os, const vector<V, Alloc>& values) {
+	static_assert(std::is_trivially_copyable<V>::value, "Type is not trivially copyable");
+	writeBinary(os, (unsigned long long)values.size());
+	os.write((const char*)values.data(), values.size() * sizeof(V));
+}
+
+/**
+ * @brief Read a vector of trivially copyable values written by writeBinaryVector.
+ * @tparam V Type of the values.
+ * @param is Input stream of the snapshot.
+ * @param values The values to read.
+ */
+template<typename V, typename Alloc>
+void readBinaryVector(istream& is, vector<V, Alloc>& values) {
+	static_assert(std::is_trivially_copyable<V>::value, "Type is not trivially copyable");
+	unsigned long long size;
+	readBinary(is, size);
+	values.resize(size);
+	is.read((char*)values.data(), size * sizeof(V));
+	if (!is) {
+		string msg = "ERROR: The snapshot is truncated or corrupted!\n";
+		std::cout << msg;
+		throw std::invalid_argument(msg);
+	}
+}
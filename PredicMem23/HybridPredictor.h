@@ -0,0 +1,293 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//    Copyright (c) 2024  Pablo Snchez Cuevas                    //
+//                                                                             //
+//    This file is part of PredicMem23.                                            //
+//                                                                             //
+//    PredicMem23 is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by     //
+//    the Free Software Foundation, either version 3 of the License, or        //
+//    (at your option) any later version.                                      //
+//                                                                             //
+//    PredicMem23 is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the              //
+//    GNU General Public License for more details.                             //
+//                                                                             //
+//    You should have received a copy of the GNU General Public License        //
+//    along with PredicMem23. If not, see <
+// http://www.gnu.org/licenses/>.
+//
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include "Global.h"
+#include "PredictorModel.h"
+#include "PredictorSVM.h"
+#include "KOrderDFCM.h"
+
+using namespace std;
+
+/**
+ * @brief HybridPredictor Class that combines a BufferSVM and a KOrderDFCM with a per-PC tournament chooser.
+ *
+ * Both components see the same accesses in a single pass: the SVM simulates the buffers dataset of the experiment,
+ * and notifies the hybrid of every access in the order of the trace (see SVMAccessObserver), which then predicts it
+ * with the DFCM, chooses the component and trains the DFCM and the chooser. The chooser is an untagged table of
+ * saturating counters indexed by the instruction, which moves towards the component that hits whenever only one of
+ * them does, and picks the DFCM when its counter is in the upper half.
+ *
+ * With a prefetch simulator, the next accesses of the instruction of every access are prefetched by the component
+ * that the chooser picks for them: the ones chained by the DFCM, or the ones predicted by the SVM in the same pass.
+ *
+ * @tparam T_pred Type of the multi-class classifier of the SVM.
+ * @tparam Delta Type representing the delta between two accesses.
+ */
+template<typename T_pred, typename Delta>
+class HybridPredictor : public PredictorModel<L64bu, int>, public SVMAccessObserver {
+protected:
+    int numPartsToPrint = 10000; /**< Number of parts to print during simulation for progress tracking. */
+    AccessesDataset<L64bu, L64bu> data; /**< The dataset of accesses (shared by both components). */
+    long numSVMHits = 0; /**< Number of hits of the SVM during simulation. */
+    long numDFCMHits = 0; /**< Number of hits of the DFCM during simulation. */
+    long numDFCMChoices = 0; /**< Number of accesses for which the chooser picks the DFCM during simulation. */
+
+    /**
+     * @brief Get the maximum value of the chooser counters.
+     * @return The maximum count.
+     */
+    unsigned char getMaxChooserCount() {
+        return (unsigned char)((1 << this->numChooserBits) - 1);
+    }
+
+    /**
+     * @brief Get the index of the chooser counter of an instruction.
+     * @param instruction The instruction.
+     * @return The index in the chooser table.
+     */
+    size_t getChooserIndex(L64bu instruction) {
+        return (size_t)(instruction & ((1ULL << this->numChooserIndexBits) - 1));
+    }
+
+public:
+    long numHits = 0; /**< Number of hits of the chosen predictions during simulation. */
+    double hitRate = 0.0; /**< The hit rate of the chosen predictions during simulation. */
+
+    shared_ptr<SVM<T_pred, int>> svm; /**< The SVM component. */
+    shared_ptr<KOrderDFCM<L64bu, Delta>> dfcm; /**< The DFCM component. */
+    vector<unsigned char> chooserTable; /**< The per-PC chooser counters (upper half: DFCM). */
+
+    int numChooserIndexBits = 12; /**< Number of index bits of the chooser table. */
+    int numChooserBits = 2; /**< Number of bits of the chooser counters. */
+
+    bool countMemoryCapacity = false; /**< Flag to determine if memory costs are calculated. */
+    shared_ptr<PrefetchCacheSimulator<L64bu>> prefetchSimulator = nullptr; /**< Data caches fed with the chosen predictions as prefetches (nullptr if not simulated). */
+
+    /**
+     * @brief Constructor from the two components.
+     *
+     * @param svm The SVM component, configured for the buffers of the experiment.
+     * @param dfcm The DFCM component.
+     * @param numChooserIndexBits Number of index bits of the chooser table.
+     * @param countTotalMemoryCost Flag to count memory costs or not.
+     */
+    HybridPredictor(shared_ptr<SVM<T_pred, int>> svm, shared_ptr<KOrderDFCM<L64bu, Delta>> dfcm, int numChooserIndexBits = 12,
+        bool countTotalMemoryCost = true) {
+        this->svm = svm;
+        this->dfcm = dfcm;
+        this->numChooserIndexBits = numChooserIndexBits;
+        this->svm->accessObserver = this;
+        initializePredictor();
+        this->countMemoryCapacity = !countTotalMemoryCost;
+    }
+
+    /**
+     * @brief Destructor for cleaning up resources.
+     */
+    ~HybridPredictor() {
+        clean();
+    }
+
+    /**
+     * @brief Clean up resources and reset state.
+     */
+    void clean() {
+        this->svm->clean();
+        this->dfcm->clean();
+        this->data = {};
+    }
+
+    /**
+     * @brief Import a new access dataset and its buffers dataset.
+     *
+     * @param data The access dataset to import (used by the DFCM and the chooser).
+     * @param datasetClases The dataset of classes (used by the SVM).
+     */
+    void importData(AccessesDataset<L64bu, L64bu>& data, BuffersDataset<int>& datasetClases) {
+        this->data = data;
+        this->svm->observerPrefetches = this->prefetchSimulator != nullptr;
+        this->svm->importData(data, datasetClases);
+    }
+
+    /**
+     * @brief Write the state of both components and the chooser into a binary snapshot.
+     *
+     * @param os Output stream of the snapshot.
+     */
+    void save(ostream& os) {
+        this->svm->save(os);
+        this->dfcm->save(os);
+        writeBinaryVector(os, this->chooserTable);
+    }
+
+    /**
+     * @brief Restore the state of both components and the chooser from a binary snapshot written by save.
+     *
+     * @param is Input stream of the snapshot.
+     */
+    void load(istream& is) {
+        this->svm->load(is);
+        this->dfcm->load(is);
+        readBinaryVector(is, this->chooserTable);
+    }
+
+    /**
+     * @brief Initialize the DFCM and the chooser (the SVM is initialized by its own simulation).
+     *
+     * The counters start weakly on the side of the SVM.
+     */
+    void initializePredictor() {
+        this->dfcm->initializePredictor();
+        this->chooserTable = vector<unsigned char>((size_t)1 << this->numChooserIndexBits, getMaxChooserCount() / 2);
+    }
+
+    /**
+     * @brief Predict an access with the DFCM, choose the component and train the DFCM and the chooser with it.
+     *
+     * It is called by the SVM for every access, in the order of the trace, once the SVM has predicted the access.
+     *
+     * @param i Index of the access.
+     * @param isSVMHit Whether the SVM predicted the access.
+     * @param svmNextAccesses Next accesses of the instruction predicted by the SVM (if they are prefetched).
+     */
+    void accessSimulated(int i, bool isSVMHit, span<const L64bu> svmNextAccesses) {
+        L64bu input = data.accessesInstructions[i];
+        L64bu output = data.accesses[i];
+        L64bu predictedOutput = 0;
+        bool isDFCMHit = this->dfcm->predict(input, &predictedOutput) && output == predictedOutput;
+
+        unsigned char maxChooserCount = getMaxChooserCount();
+        unsigned char& counter = this->chooserTable[getChooserIndex(input)];
+        bool isDFCMChosen = counter > maxChooserCount / 2;
+        if (isDFCMChosen) numDFCMChoices++;
+        if (isDFCMChosen ? isDFCMHit : isSVMHit) numHits++;
+        if (isSVMHit) numSVMHits++;
+        if (isDFCMHit) numDFCMHits++;
+
+        // The chooser only learns from the accesses where a single component hits:
+        if (isDFCMHit && !isSVMHit && counter < maxChooserCount) counter++;
+        else if (isSVMHit && !isDFCMHit && counter > 0) counter--;
+
+        this->dfcm->fit(input, output);
+
+        // Once both components are trained with this access, the one chosen for the instruction prefetches:
+        if (this->prefetchSimulator != nullptr) {
+            this->prefetchSimulator->access(output);
+            if (counter > maxChooserCount / 2)
+                this->dfcm->prefetchAhead(input, *this->prefetchSimulator);
+            else {
+                for (auto nextAccess : svmNextAccesses)
+                    this->prefetchSimulator->prefetch(nextAccess);
+            }
+        }
+
+        if (i % numPartsToPrint == 0) {
+            std::cout << input << " -> " << output << " vs " << predictedOutput << std::endl;
+            std::cout << "Hit rate: " << static_cast<double>(numHits) / (i + 1)
+                << " ; " << static_cast<double>(i) / data.accesses.size() << std::endl;
+        }
+    }
+
+    /**
+     * @brief Simulate both components and the chooser on the dataset, in a single pass driven by the SVM.
+     *
+     * @param initialize Whether to initialize the predictor before simulation.
+     * @return Shared pointer to a structure containing prediction results and costs.
+     */
+    shared_ptr<PredictResultsAndCosts> simulate(bool initialize = true) {
+        HybridPredictResultsAndCosts resultsAndCosts;
+
+        if (initialize) {
+            this->initializePredictor();
+        }
+
+        if (this->svm->outputData.size() != data.accesses.size()) {
+            string msg = "ERROR: The buffers dataset of the hybrid predictor does not match its accesses!\n";
+            std::cout << msg;
+            throw std::invalid_argument(msg);
+        }
+
+        if (this->prefetchSimulator != nullptr) {
+            if (initialize) this->prefetchSimulator->reset();
+            else this->prefetchSimulator->resetCounters();
+        }
+
+        numHits = 0;
+        hitRate = 0.0;
+        numSVMHits = 0;
+        numDFCMHits = 0;
+        numDFCMChoices = 0;
+
+        // The SVM notifies every access to accessSimulated:
+        auto svmResultsPointer = this->svm->simulate(initialize);
+        BuffersSVMPredictResultsAndCosts* svmResults = (BuffersSVMPredictResultsAndCosts*)svmResultsPointer.get();
+
+        hitRate = static_cast<double>(numHits) / data.accesses.size();
+
+        resultsAndCosts.hitRate = hitRate;
+        resultsAndCosts.cacheMissRate = svmResults->cacheMissRate;
+        resultsAndCosts.dictionaryMissRate = svmResults->dictionaryMissRate;
+        resultsAndCosts.numShards = svmResults->numShards;
+        resultsAndCosts.sequentialHitRate = svmResults->sequentialHitRate;
+        resultsAndCosts.svmHitRate = static_cast<double>(numSVMHits) / data.accesses.size();
+        resultsAndCosts.dfcmHitRate = static_cast<double>(numDFCMHits) / data.accesses.size();
+        resultsAndCosts.dfcmChoiceRate = static_cast<double>(numDFCMChoices) / data.accesses.size();
+        resultsAndCosts.svmModelMemoryCost = svmResults->modelMemoryCost;
+        resultsAndCosts.dfcmMemoryCost = getDFCMMemoryCost();
+        resultsAndCosts.chooserMemoryCost = getChooserMemoryCost();
+        resultsAndCosts.modelMemoryCost = resultsAndCosts.svmModelMemoryCost + resultsAndCosts.dfcmMemoryCost +
+            resultsAndCosts.chooserMemoryCost;
+        resultsAndCosts.totalMemoryCost = resultsAndCosts.modelMemoryCost;
+        if (this->prefetchSimulator != nullptr)
+            resultsAndCosts.prefetch = this->prefetchSimulator->getResults();
+        return shared_ptr<PredictResultsAndCosts>((PredictResultsAndCosts*)
+            new HybridPredictResultsAndCosts(resultsAndCosts));
+    }
+
+    /**
+     * @brief Calculate the memory cost of the DFCM.
+     *
+     * The first table of the DFCM has the geometry of the history cache of the SVM, but it is a separate table that
+     * keeps the deltas of the instructions (not their classes), so it is costed in full, as the second table.
+     *
+     * @return Memory cost in bytes.
+     */
+    double getDFCMMemoryCost() {
+        double firstTableCost, secondTableCost;
+        return this->countMemoryCapacity ? this->dfcm->getMemoryCosts(&firstTableCost, &secondTableCost) :
+            this->dfcm->getTotalMemoryCosts(&firstTableCost, &secondTableCost);
+    }
+
+    /**
+     * @brief Calculate the memory cost of the chooser table.
+     *
+     * @return Memory cost in bytes.
+     */
+    double getChooserMemoryCost() {
+        return this->chooserTable.size() * this->numChooserBits / 8.0;
+    }
+};
@@ -65,4 +65,25 @@ public:
      * @brief Clean up the predictor model resources.
      */
 	virtual void clean() = 0;
+    /**
+     * @brief Write the trained state of the predictor model into a binary snapshot.
+     *
+     * @param os Output stream of the snapshot.
+     */
+	virtual void save(ostream& os) {
+		string msg = "ERROR: The predictor model does not support snapshots!\n";
+		std::cout << msg;
+		throw std::invalid_argument(msg);
+	}
+    /**
+     * @brief Restore the trained state of the predictor model from a binary snapshot written by save.
+     *
+     * The model must have been built with the same parameters, and simulated afterwards without initializing it.
+     * @param is Input stream of the snapshot.
+     */
+	virtual void load(istream& is) {
+		string msg = "ERROR: The predictor model does not support snapshots!\n";
+		std::cout << msg;
+		throw std::invalid_argument(msg);
+	}
 };
\ No newline at end of file
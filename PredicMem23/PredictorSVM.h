@@ -24,14 +24,49 @@
 #pragma once
 #include <string>
 #include <iostream>
+#include <deque>
 #include "SVMClassifier.hpp"
 #include "BuffersSimulator.h"
+#include "PrefetchCacheSimulator.h"
 //#include "Experimentation.h"
 #include "Global.h"
 #include "PredictorModel.h"
 
 using namespace std;
 
+/**
+ * @brief Encodings of the history of classes given as input to the SVM.
+ *
+ * - Scaled: Each class is a single feature, scaled as class / numInputClasses + 1 (ordinal).
+ * - OneHot: Each position of the history has a binary feature per input class (including the invalid one).
+ * - Hashed: The (position, class) pairs are hashed into a smaller table of binary features.
+ */
+enum class SVMInputEncoding { Scaled, OneHot, Hashed };
+
+/**
+ * @brief Policies to partition the accesses among the shards (banks) of a sharded SVM predictor.
+ *
+ * - PCHash: By a hash of the instruction of the access.
+ * - CacheSet: By the set of the history cache of the access (interleaving the sets among the shards).
+ */
+enum class SVMShardingType { PCHash, CacheSet };
+
+/**
+ * @brief Observer of the accesses simulated by an SVM (e.g. a hybrid predictor that runs other components in the same
+ * pass), which is notified of every access in the order of the trace.
+ */
+class SVMAccessObserver {
+public:
+    /**
+     * @brief Notify that an access has been predicted and the model has been trained with it.
+     * @param i Index of the access.
+     * @param isHit Whether the SVM predicted the access.
+     * @param nextAccesses Next accesses of the instruction predicted by the SVM once trained with this one (empty
+     * unless the observer prefetches them, see SVM::observerPrefetches).
+     */
+    virtual void accessSimulated(int i, bool isHit, span<const L64bu> nextAccesses) = 0;
+};
+
 /**
  * @brief Template class for a Support Vector Machine (SVM) model used as a predictor.
  *
@@ -46,17 +81,372 @@ class SVM : PredictorModel<L64bu, T_input> {
 
 private:
     int numPartsToPrint = 10000; ///< Number of parts to print during simulation.
-    int numInputClasses; ///< The number of input classes.
+    int numInputClasses = 0; ///< The number of input classes.
+
+    /**
+     * @brief State of the simulation of a model over a stream of accesses (all of them, or the ones of a shard).
+     */
+    struct ModelStream {
+        T_pred* model = nullptr; ///< Model that predicts and is trained with the accesses of the stream.
+        deque<int> pendingSamples; ///< Mispredicted samples whose update is pending, in order of arrival.
+        deque<pair<int, int>> closedBatches; ///< Access before which each closed mini-batch is applied, and its number of samples.
+        int numOpenSamples = 0; ///< Number of pending samples that are not in a closed mini-batch yet.
+        vector<span<const float>> batchInputs; ///< Inputs of the mini-batch being applied, reused by every mini-batch.
+        vector<span<const int>> batchFeatures; ///< Active features of the mini-batch being applied, reused by every mini-batch.
+        vector<int> batchOutputs; ///< Outputs of the mini-batch being applied, reused by every mini-batch.
+        long numHits = 0; ///< Number of hits of the stream.
+        LookaheadCounters lookahead; ///< Counters of the predictions ahead of the accesses of the stream.
+        vector<char> chainedHistory; ///< History with the predicted classes fed back, reused by every access.
+        vector<float> chainedInput; ///< Scaled encoding of the chained history, reused by every access.
+        vector<int> chainedFeatures; ///< Active features of the chained history (sparse encodings), reused by every access.
+        bool predictsNextAccesses = false; ///< Whether the next accesses of the instruction of every access are predicted.
+        vector<L64b> classDeltas; ///< Delta of every class as of the last access of the stream (see classDeltaUpdates).
+        size_t numClassDeltaUpdates = 0; ///< Number of updates of classDeltaUpdates already applied to classDeltas.
+        vector<L64bu> nextAccesses; ///< Next accesses predicted for the instruction of the last access of the stream.
+    };
+
+    /**
+     * @brief Options of a simulation, derived once from the imported data.
+     */
+    struct SimulationOptions {
+        bool isSparse = false; ///< Whether the inputs have a sparse encoding.
+        bool isBatched = false; ///< Whether the mispredicted samples are applied in mini-batches.
+        bool isMemoized = false; ///< Whether the predictions of the model are memoized.
+        bool isLookahead = false; ///< Whether the predictions ahead of the accesses are scored.
+    };
+
+    /**
+     * @brief Gets the options of a simulation over the imported data.
+     *
+     * @return The options.
+     */
+    SimulationOptions getSimulationOptions() {
+        SimulationOptions options;
+        options.isSparse = this->inputEncoding != SVMInputEncoding::Scaled;
+        options.isBatched = this->numBatchSamples > 1 || this->updateDelay > 0;
+        options.isMemoized = this->inputHistories.size() == this->outputData.size() && getNumHistories() > 0;
+        options.isLookahead = this->predictionDegree > 1 && this->nextInstructionAccesses.size() == this->outputData.size() &&
+            this->inputClasses.size() == this->outputData.size() * this->numSequenceElements;
+        return options;
+    }
+
+    /**
+     * @brief Trains the model of a stream with its oldest pending samples, as a single mini-batch.
+     *
+     * @param stream The stream.
+     * @param numSamples Number of pending samples of the mini-batch.
+     */
+    void applyPendingSamples(ModelStream& stream, int numSamples) {
+        stream.batchInputs.clear();
+        stream.batchFeatures.clear();
+        stream.batchOutputs.clear();
+        for (int j = 0; j < numSamples; j++) {
+            int i = stream.pendingSamples.front();
+            stream.pendingSamples.pop_front();
+            if (this->inputEncoding == SVMInputEncoding::Scaled) stream.batchInputs.push_back(this->inputData[i]);
+            else stream.batchFeatures.push_back(this->inputFeatures[i]);
+            stream.batchOutputs.push_back(this->outputData[i]);
+        }
+
+        if (this->inputEncoding == SVMInputEncoding::Scaled) stream.model->fitBatch(stream.batchInputs, stream.batchOutputs);
+        else stream.model->fitSparseBatch(stream.batchFeatures, stream.batchOutputs);
+    }
+
+    /**
+     * @brief Applies the closed mini-batches of a stream whose update is due before an access.
+     *
+     * @param stream The stream.
+     * @param i Index of the access.
+     */
+    void applyDueBatches(ModelStream& stream, int i) {
+        while (!stream.closedBatches.empty() && stream.closedBatches.front().first <= i) {
+            applyPendingSamples(stream, stream.closedBatches.front().second);
+            stream.closedBatches.pop_front();
+        }
+    }
+
+    /**
+     * @brief Predicts the class that follows the chained history of a stream, without training the model.
+     *
+     * @param stream The stream.
+     * @param isMemoized Whether the predictions of the model are memoized.
+     * @return The predicted class.
+     */
+    int predictChainedHistory(ModelStream& stream, bool isMemoized) {
+        int numElements = this->numSequenceElements;
+        if (this->inputEncoding == SVMInputEncoding::Scaled) {
+            int history = 0;
+            stream.chainedInput.resize(numElements);
+            for (int k = 0; k < numElements; k++) {
+                int class_ = stream.chainedHistory[k];
+                stream.chainedInput[k] = (float)(((float)class_) / numInputClasses + 1.0);
+                history = history * (this->numClasses + 2) + class_ + 1;
+            }
+            return isMemoized ? stream.model->predictMemoized(history, stream.chainedInput) :
+                stream.model->predictOne(stream.chainedInput);
+        }
+
+        stream.chainedFeatures.resize(numElements);
+        for (int k = 0; k < numElements; k++)
+            stream.chainedFeatures[k] = getFeatureIndex(k, stream.chainedHistory[k]);
+        return stream.model->predictSparse(stream.chainedFeatures);
+    }
+
+    /**
+     * @brief Scores the predictions of several accesses ahead of an access, feeding each predicted class back into the
+     * history to predict the next one (without training the model).
+     *
+     * The prediction of depth d is a hit if the classes predicted up to it are those of the next d accesses of the
+     * instruction (from this one on) and none of them misses in the buffers, since the predicted address adds their
+     * deltas. Once a depth misses, the next ones are issued but cannot hit, so they are not predicted.
+     *
+     * @param stream The stream.
+     * @param i Index of the access.
+     * @param predictedOutput Class predicted for the access (depth 1).
+     * @param isMemoized Whether the predictions of the model are memoized.
+     */
+    void scoreLookahead(ModelStream& stream, int i, int predictedOutput, bool isMemoized) {
+        int numElements = this->numSequenceElements;
+        auto classes = this->inputClasses.begin() + (size_t)i * numElements;
+        stream.chainedHistory.assign(classes, classes + numElements);
+
+        for (int d = 0, j = i; d < this->predictionDegree; d++) {
+            if (d > 0) {
+                if (numElements > 0) {
+                    std::copy(stream.chainedHistory.begin() + 1, stream.chainedHistory.end(), stream.chainedHistory.begin());
+                    stream.chainedHistory.back() = (char)predictedOutput;
+                }
+                predictedOutput = predictChainedHistory(stream, isMemoized);
+            }
+
+            stream.lookahead.numPredictions[d]++;
+            if (j >= 0 && outputData[j] == predictedOutput && !dictionaryMissesMask[j] && !inputBufferMissesMask[j]) {
+                stream.lookahead.numHits[d]++;
+                j = nextInstructionAccesses[j];
+            }
+            else {
+                for (d++; d < this->predictionDegree; d++)
+                    stream.lookahead.numPredictions[d]++;
+            }
+        }
+    }
+
+    /**
+     * @brief Predicts the next accesses of the instruction of an access with the model of a stream, once trained with
+     * the access, so that they can be prefetched.
+     *
+     * The input of the next access of the instruction is its history as of this access, so its class is predicted
+     * with it and the delta of the class (as assigned by the dictionary up to this access) is added to the last
+     * access recorded for it, which is this one. With a prediction degree, the predicted classes are fed back into
+     * the history to chain the following accesses, as scoreLookahead does. Nothing is predicted if the instruction
+     * is not accessed again in the data, or if its history misses in the buffers by then.
+     *
+     * @param stream The stream.
+     * @param i Index of the access.
+     * @param options Options of the simulation.
+     */
+    void predictNextAccesses(ModelStream& stream, int i, const SimulationOptions& options) {
+        // The deltas of the classes are brought up to this access:
+        while (stream.numClassDeltaUpdates < this->classDeltaUpdates.size() &&
+            this->classDeltaUpdates[stream.numClassDeltaUpdates].access <= i) {
+            auto& update = this->classDeltaUpdates[stream.numClassDeltaUpdates++];
+            stream.classDeltas[update.class_] = update.delta;
+        }
+
+        stream.nextAccesses.clear();
+        int j = this->nextInstructionAccesses[i];
+        if (j < 0 || this->inputBufferMissesMask[j])
+            return;
+
+        T_pred& model = *stream.model;
+        int predictedOutput = options.isSparse ? model.predictSparse(inputFeatures[j]) :
+            options.isMemoized ? model.predictMemoized(inputHistories[j], inputData[j]) : model.predictOne(inputData[j]);
+
+        int numElements = this->numSequenceElements;
+        if (this->predictionDegree > 1) {
+            auto classes = this->inputClasses.begin() + (size_t)j * numElements;
+            stream.chainedHistory.assign(classes, classes + numElements);
+        }
+
+        L64bu nextAccess = this->lastAccesses[j];
+        for (int d = 0; d < this->predictionDegree; d++) {
+            if (d > 0) {
+                if (numElements > 0) {
+                    std::copy(stream.chainedHistory.begin() + 1, stream.chainedHistory.end(), stream.chainedHistory.begin());
+                    stream.chainedHistory.back() = (char)predictedOutput;
+                }
+                predictedOutput = predictChainedHistory(stream, options.isMemoized);
+            }
+            if (predictedOutput < 0 || predictedOutput >= this->numClasses)
+                break;
+            nextAccess += (L64bu)stream.classDeltas[predictedOutput];
+            stream.nextAccesses.push_back(nextAccess);
+        }
+    }
+
+    /**
+     * @brief Predicts an access with the model of a stream and trains the model with it.
+     *
+     * @param stream The stream.
+     * @param i Index of the access.
+     * @param options Options of the simulation.
+     * @param print Whether to print the progress.
+     * @return Whether the access was predicted (a hit).
+     */
+    bool simulateAccess(ModelStream& stream, int i, const SimulationOptions& options, bool print) {
+        T_pred& model = *stream.model;
+        if (options.isBatched)
+            applyDueBatches(stream, i);
+
+        int output = outputData[i];
+        auto isInputPredictable = predictableInputsMask[i];
+        auto inputBufferMiss = inputBufferMissesMask[i];
+        auto dictionaryMiss = dictionaryMissesMask[i];
+
+        int predictedOutput = -1;
+        if (isInputPredictable)
+            predictedOutput = options.isSparse ? model.predictSparse(inputFeatures[i]) :
+                options.isMemoized ? model.predictMemoized(inputHistories[i], inputData[i]) : model.predictOne(inputData[i]);
+
+        if (options.isLookahead && isInputPredictable)
+            scoreLookahead(stream, i, predictedOutput, options.isMemoized);
+
+        bool predictionMiss = (output != predictedOutput);
+
+        // If thre was a miss, the fitting is performed with the input and output sample:
+        bool performFitting = !inputBufferMiss && (predictionMiss || dictionaryMiss);
+        if (performFitting && options.isBatched) {
+            stream.pendingSamples.push_back(i);
+            if (++stream.numOpenSamples >= this->numBatchSamples) {
+                stream.closedBatches.push_back(pair<int, int>(i + 1 + this->updateDelay, stream.numOpenSamples));
+                stream.numOpenSamples = 0;
+            }
+        }
+        else if (performFitting) {
+            if (options.isSparse) model.fitSparse(inputFeatures[i], output);
+            else model.fitOne(inputData[i], output);
+        }
+
+        bool hit = isInputPredictable && !dictionaryMiss && !inputBufferMiss && !predictionMiss;
+        if (hit)
+            stream.numHits++;
+
+        if (stream.predictsNextAccesses)
+            predictNextAccesses(stream, i, options);
+
+        if (print && i % numPartsToPrint == 0) {
+            string in = "";
+            if (options.isSparse) {
+                for (auto f : inputFeatures[i])
+                    in += to_string(f) + ", ";
+            }
+            else {
+                for (auto e : inputData[i])
+                    in += to_string((e - 1.0) * numInputClasses) + ", ";
+            }
+            std::cout << in << " -> " << output << " vs " << predictedOutput << std::endl;
+            std::cout << "Hit rate: " << (double)stream.numHits / (i + 1) << " ; " << ((double)i) / outputData.size() << std::endl;
+        }
+        return hit;
+    }
+
+    /**
+     * @brief Applies the pending samples of a stream at the end of the data, so that the model continues with them.
+     *
+     * @param stream The stream.
+     * @param options Options of the simulation.
+     */
+    void finishStream(ModelStream& stream, const SimulationOptions& options) {
+        if (options.isBatched) {
+            while (!stream.closedBatches.empty()) {
+                applyPendingSamples(stream, stream.closedBatches.front().second);
+                stream.closedBatches.pop_front();
+            }
+            if (stream.numOpenSamples > 0)
+                applyPendingSamples(stream, stream.numOpenSamples);
+            stream.numOpenSamples = 0;
+        }
+    }
+
+    /**
+     * @brief Completes an access in the order of the trace: it is demanded from the prefetch simulator (if any),
+     * which is then given the next accesses predicted for its instruction, and the observer (if any) is notified.
+     *
+     * @param stream The stream that simulated the access.
+     * @param i Index of the access.
+     * @param hit Whether the access was predicted.
+     */
+    void completeAccess(ModelStream& stream, int i, bool hit) {
+        if (this->prefetchSimulator != nullptr) {
+            this->prefetchSimulator->access(this->accesses[i]);
+            for (auto nextAccess : stream.nextAccesses)
+                this->prefetchSimulator->prefetch(nextAccess);
+        }
+        if (this->accessObserver != nullptr)
+            this->accessObserver->accessSimulated(i, hit, stream.nextAccesses);
+    }
+
+    /**
+     * @brief Predicts and trains the model of a stream with its accesses, in order.
+     *
+     * If the stream has all the accesses, each one is completed in order too (see completeAccess).
+     *
+     * @param stream The stream.
+     * @param indices Indices of the accesses of the stream (nullptr for all the accesses).
+     * @param options Options of the simulation.
+     * @param print Whether to print the progress.
+     */
+    void simulateStream(ModelStream& stream, const vector<int>* indices, const SimulationOptions& options, bool print) {
+        size_t numAccesses = indices != nullptr ? indices->size() : outputData.size();
+        for (size_t n = 0; n < numAccesses; n++) {
+            int i = indices != nullptr ? (*indices)[n] : (int)n;
+            bool hit = simulateAccess(stream, i, options, print);
+            if (indices == nullptr)
+                completeAccess(stream, i, hit);
+        }
+        finishStream(stream, options);
+    }
+
+    /**
+     * @brief Gets the shard of an access, from its instruction.
+     *
+     * @param instruction The instruction of the access.
+     * @return The index of the shard.
+     */
+    int getShard(L64bu instruction) {
+        if (this->shardingType == SVMShardingType::CacheSet && this->numShardIndexBits > 0)
+            return (int)((instruction & ((1ULL << this->numShardIndexBits) - 1)) % this->numShards);
+
+        // PC hash (SplitMix64 finalizer), so that close instructions are spread over the shards:
+        L64bu h = instruction;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+        h = h ^ (h >> 31);
+        return (int)(h % this->numShards);
+    }
 
 public:
-    vector<vector<float>> inputData = vector<vector<float>>(); ///< Input data for training.
+    vector<vector<float>> inputData = vector<vector<float>>(); ///< Input data for training (scaled encoding).
+    vector<vector<int>> inputFeatures = vector<vector<int>>(); ///< Active features of the input data (sparse encodings).
+    vector<int> inputHistories = vector<int>(); ///< Packed history of each input, to look up memoized predictions.
+    vector<L64bu> inputInstructions = vector<L64bu>(); ///< Instruction of each input, to choose its shard or its next accesses.
+    vector<char> inputClasses = vector<char>(); ///< Classes of the history of each input, flattened (only to predict ahead).
+    vector<int> nextInstructionAccesses = vector<int>(); ///< Next access of the instruction of each input (only to predict ahead).
     vector<char> outputData = vector<char>(); ///< Output data for training.
     vector<char> predictableInputsMask = vector<char>(); ///< Mask for predictable inputs.
     vector<char> inputBufferMissesMask = vector<char>(); ///< Mask for input buffer misses.
     vector<char> dictionaryMissesMask = vector<char>(); ///< Mask for dictionary misses.
+    vector<L64bu> accesses = vector<L64bu>(); ///< Accessed address of each input (only to prefetch).
+    vector<L64bu> lastAccesses = vector<L64bu>(); ///< Last access of the instruction of each input (only to predict the next accesses).
+    vector<ClassDeltaUpdate<T_input>> classDeltaUpdates = vector<ClassDeltaUpdate<T_input>>(); ///< Log of the deltas assigned to the classes (only to predict the next accesses).
 
     long numHits = 0; ///< Number of hits during simulation.
-    int numBatchSamples = 1; ///< Number of batch samples.
+    SVMAccessObserver* accessObserver = nullptr; ///< Observer notified of every access in the order of the trace (not owned).
+    bool observerPrefetches = false; ///< Whether the observer is given the predicted next accesses of every access, to prefetch them.
+    shared_ptr<PrefetchCacheSimulator<L64bu>> prefetchSimulator = nullptr; ///< Data caches fed with the predictions as prefetches (nullptr if not simulated).
+    int predictionDegree = 1; ///< Number of accesses of each instruction predicted ahead (1: only the next one).
+    int numBatchSamples = 1; ///< Number of mispredicted samples per training mini-batch (1 for online training).
+    int updateDelay = 0; ///< Number of accesses between the closing of a mini-batch and the update of the model.
     int numRepetitions = 1; ///< Number of repetitions during simulation.
     double hitRate = 0.0; ///< The hit rate of the model.
     T_pred model; ///< The SVM model.
@@ -65,6 +455,12 @@ public:
     int numClasses = 0; ///< Number of output classes.
 
     bool predictOnNonValidInput; ///< Flag indicating whether to predict on non-valid inputs.
+    SVMInputEncoding inputEncoding = SVMInputEncoding::Scaled; ///< Encoding of the input history.
+    long maxMemoizedHistories = 65536; ///< Maximum number of distinct histories for the predictions to be memoized.
+    int numShards = 1; ///< Number of shards with their own model (1 for a single shared model).
+    SVMShardingType shardingType = SVMShardingType::PCHash; ///< Policy to partition the accesses among the shards.
+    int numShardIndexBits = 0; ///< Number of index bits of the history cache, to shard by cache set.
+    vector<T_pred> shardModels = vector<T_pred>(); ///< Model of each shard.
 
     /**
      * @brief Destructor for the SVM class, performs cleanup.
@@ -80,10 +476,22 @@ public:
      */
     void clean() {
         this->inputData = vector<vector<float>>();
+        this->inputFeatures = vector<vector<int>>();
+        this->inputHistories = vector<int>();
+        this->inputInstructions = vector<L64bu>();
+        this->inputClasses = vector<char>();
+        this->nextInstructionAccesses = vector<int>();
         this->outputData = vector<char>();
         this->predictableInputsMask = vector<char>();
         this->inputBufferMissesMask = vector<char>();
         this->dictionaryMissesMask = vector<char>();
+        this->accesses = vector<L64bu>();
+        this->lastAccesses = vector<L64bu>();
+        this->classDeltaUpdates = vector<ClassDeltaUpdate<T_input>>();
+
+        // The models are released too, with their memoization tables (see allocateModelTables):
+        this->model = T_pred();
+        this->shardModels = vector<T_pred>();
     }
 
     /**
@@ -95,13 +503,17 @@ public:
      * @param numSequenceElements The number of sequence elements.
      * @param numClasses The number of output classes.
      * @param predictOnNonValidInput Flag indicating whether to predict on non-valid input.
+     * @param inputEncoding Encoding of the input history.
      */
-    SVM(BuffersDataset<T_input> classesDataset, int numSequenceElements, int numClasses, bool predictOnNonValidInput) {
+    SVM(BuffersDataset<T_input> classesDataset, int numSequenceElements, int numClasses, bool predictOnNonValidInput,
+        SVMInputEncoding inputEncoding = SVMInputEncoding::Scaled) {
         static_assert(std::is_base_of<MultiSVMClassifier, T_pred>::value, "Class is not sub-type of MultiSVMClassifier");
 
         this->numSequenceElements = numSequenceElements;
         this->numClasses = numClasses;
         this->predictOnNonValidInput = predictOnNonValidInput;
+        this->inputEncoding = inputEncoding;
+        this->numInputClasses = numClasses;
         if (predictOnNonValidInput) numInputClasses++;
 
         importData(classesDataset);
@@ -116,13 +528,17 @@ public:
      * @param numSequenceElements The number of sequence elements.
      * @param numClasses The number of output classes.
      * @param predictOnNonValidInput Flag indicating whether to predict on non-valid input.
+     * @param inputEncoding Encoding of the input history.
      */
-    SVM(int numSequenceElements, int numClasses, bool predictOnNonValidInput) {
+    SVM(int numSequenceElements, int numClasses, bool predictOnNonValidInput,
+        SVMInputEncoding inputEncoding = SVMInputEncoding::Scaled) {
         static_assert(std::is_base_of<MultiSVMClassifier, T_pred>::value, "Class is not sub-type of MultiSVMClassifier");
 
         this->numSequenceElements = numSequenceElements;
         this->numClasses = numClasses;
         this->predictOnNonValidInput = predictOnNonValidInput;
+        this->inputEncoding = inputEncoding;
+        this->numInputClasses = numClasses;
         if (predictOnNonValidInput) numInputClasses++;
 
         initializeModel();
@@ -151,6 +567,22 @@ public:
      */
     void importData(AccessesDataset<L64bu, L64bu>& data, BuffersDataset<T_input>& classesDataset) {
         importData(classesDataset);
+
+        // The instructions are only needed to partition the accesses among the shards, or to find their next accesses:
+        if (this->numShards > 1 || this->predictionDegree > 1 || predictsNextAccesses())
+            this->inputInstructions.insert(this->inputInstructions.end(), data.accessesInstructions.begin(),
+                data.accessesInstructions.end());
+        if (this->prefetchSimulator != nullptr)
+            this->accesses.insert(this->accesses.end(), data.accesses.begin(), data.accesses.end());
+    }
+
+    /**
+     * @brief Whether the next accesses of the instruction of every access are predicted, to prefetch them.
+     *
+     * @return True if there is a prefetch simulator, or if the observer prefetches them.
+     */
+    bool predictsNextAccesses() {
+        return this->prefetchSimulator != nullptr || (this->accessObserver != nullptr && this->observerPrefetches);
     }
 
     /**
@@ -161,23 +593,59 @@ public:
      * @param classesDataset The dataset containing input-output pairs for training.
      */
     void importData(BuffersDataset<T_input>& classesDataset) {
-        for (int i = 0; i < classesDataset.inputAccesses.size(); i++) {
-            vector<float> input = vector<float>();
+        // The next accesses are predicted from the last accesses and the deltas of the classes recorded in the dataset:
+        size_t firstAccess = this->outputData.size();
+        if (predictsNextAccesses()) {
+            if (!classesDataset.recordsLastAccesses) {
+                string msg = "ERROR: The buffers dataset does not record the last accesses to predict the next ones!\n";
+                std::cout << msg;
+                throw std::invalid_argument(msg);
+            }
+            this->lastAccesses.insert(this->lastAccesses.end(), classesDataset.lastAccesses.begin(),
+                classesDataset.lastAccesses.end());
+            for (auto update : classesDataset.classDeltaUpdates) {
+                update.access += (long)firstAccess;
+                this->classDeltaUpdates.push_back(update);
+            }
+        }
+
+        for (int i = 0; i < classesDataset.size(); i++) {
             char output = -1;
             char isInputValid = false;
 
-            for (int j = 0; j < classesDataset.inputAccesses[i].size(); j++) {
-                input.push_back(((float)classesDataset.inputAccesses[i][j]) / numInputClasses + 1.0);
-            }
+            // The input row is read with the stored type of the classes:
+            classesDataset.visitInputAccesses(i, [&](auto inputAccesses) {
+                if (this->predictionDegree > 1) {
+                    for (auto class_ : inputAccesses)
+                        this->inputClasses.push_back((char)classesDataset.decodeClass(class_));
+                }
+                if (this->inputEncoding == SVMInputEncoding::Scaled) {
+                    vector<float> input = vector<float>();
+                    input.reserve(inputAccesses.size());
+                    for (auto class_ : inputAccesses) {
+                        input.push_back(((float)classesDataset.decodeClass(class_)) / numInputClasses + 1.0);
+                    }
+                    this->inputData.push_back(input);
+                    if (getNumHistories() > 0)
+                        this->inputHistories.push_back(getHistoryIndex(classesDataset, inputAccesses));
+                }
+                else {
+                    vector<int> features = vector<int>();
+                    features.reserve(inputAccesses.size());
+                    for (int j = 0; j < inputAccesses.size(); j++) {
+                        features.push_back(getFeatureIndex(j, classesDataset.decodeClass(inputAccesses[j])));
+                    }
+                    this->inputFeatures.push_back(features);
+                }
+            });
 
             output = classesDataset.outputAccesses[i];
-            isInputValid = classesDataset.isValid[i];
+            isInputValid = classesDataset.isValid(i);
 
-            this->inputData.push_back(input);
             this->outputData.push_back(output);
             this->predictableInputsMask.push_back(isInputValid);
-            this->inputBufferMissesMask.push_back(classesDataset.isCacheMiss[i]);
-            this->dictionaryMissesMask.push_back(classesDataset.isDictionaryMiss[i]);
+            this->inputBufferMissesMask.push_back(classesDataset.isCacheMiss(i));
+            this->dictionaryMissesMask.push_back(classesDataset.isDictionaryMiss(i));
         }
     }
 
@@ -189,7 +657,134 @@ public:
     void initializeModel() {
         double c = 1.0;
         double learningRate = 0.7;
-        model = T_pred(this->numSequenceElements, this->numClasses, c, 1, learningRate);
+        model = T_pred(getNumFeatures(), this->numClasses, c, 1, learningRate);
+        this->shardModels = vector<T_pred>();
+    }
+
+    /**
+     * @brief Allocates the models of the shards, as copies of the shared model, if they are not allocated yet.
+     */
+    void allocateShardModels() {
+        if (this->numShards > 1 && this->shardModels.size() != this->numShards)
+            this->shardModels = vector<T_pred>(this->numShards, this->model);
+    }
+
+    /**
+     * @brief Allocates the models of the shards and the memoization tables of every model, before simulating.
+     *
+     * The memoization tables can take megabytes per model, and all the experiments of a sweep are built before
+     * being performed, so they are only allocated by simulate (and released by clean).
+     */
+    void allocateModelTables() {
+        allocateShardModels();
+        long numHistories = getNumHistories();
+        if (numHistories > 0) {
+            this->model.enableMemoization(numHistories);
+            for (auto& shardModel : this->shardModels)
+                shardModel.enableMemoization(numHistories);
+        }
+    }
+
+    /**
+     * @brief Gets the number of distinct input histories, if their predictions can be memoized.
+     *
+     * The predictions are memoized with the scaled encoding when every position of the history has few enough
+     * classes (from the invalid one, -1, to numClasses) for the whole space to fit in maxMemoizedHistories.
+     *
+     * @return The number of distinct histories, or 0 if the predictions are not memoized.
+     */
+    long getNumHistories() {
+        if (this->inputEncoding != SVMInputEncoding::Scaled)
+            return 0;
+        long numHistories = 1;
+        for (int j = 0; j < this->numSequenceElements; j++) {
+            numHistories *= this->numClasses + 2;
+            if (numHistories > this->maxMemoizedHistories)
+                return 0;
+        }
+        return numHistories;
+    }
+
+    /**
+     * @brief Gets the index of an input history in the memoization table, packing its classes.
+     *
+     * @param classesDataset The dataset of the input.
+     * @param inputAccesses The stored input classes.
+     * @return The index of the history.
+     */
+    template<typename C>
+    int getHistoryIndex(BuffersDataset<T_input>& classesDataset, span<const C> inputAccesses) {
+        int history = 0;
+        for (auto class_ : inputAccesses)
+            history = history * (this->numClasses + 2) + (int)classesDataset.decodeClass(class_) + 1;
+        return history;
+    }
+
+    /**
+     * @brief Gets the number of features of the classifier with the input encoding.
+     *
+     * The one-hot encoding has a feature per position of the history and input class (from the invalid one, -1,
+     * to numClasses, both included), while the hashed one folds them into half of that number, rounded up to a
+     * power of two.
+     *
+     * @return The number of features.
+     */
+    int getNumFeatures() {
+        int numOneHotFeatures = this->numSequenceElements * (this->numClasses + 2);
+        switch (this->inputEncoding) {
+        case SVMInputEncoding::OneHot:
+            return numOneHotFeatures;
+        case SVMInputEncoding::Hashed: {
+            int numHashedFeatures = 1;
+            while (numHashedFeatures < numOneHotFeatures) numHashedFeatures <<= 1;
+            return numHashedFeatures > 1 ? numHashedFeatures / 2 : 1;
+        }
+        default:
+            return this->numSequenceElements;
+        }
+    }
+
+    /**
+     * @brief Gets the index of the active feature of a class in a position of the history (sparse encodings).
+     *
+     * @param position Position in the history.
+     * @param class_ Input class (-1 if invalid).
+     * @return The index of the feature.
+     */
+    int getFeatureIndex(int position, long class_) {
+        int category = (int)class_ + 1;
+        if (this->inputEncoding == SVMInputEncoding::OneHot)
+            return position * (this->numClasses + 2) + category;
+
+        // Hashed: a multiplicative hash of the pair, folded into the power-of-two table:
+        unsigned int h = (unsigned int)(position + 1) * 0x9E3779B1u ^ (unsigned int)(category + 1) * 0x85EBCA77u;
+        h ^= h >> 15;
+        h *= 0x2C1B3C6Du;
+        h ^= h >> 13;
+        return (int)(h & (unsigned int)(getNumFeatures() - 1));
+    }
+
+    /**
+     * @brief Writes the trained classifier into a binary snapshot.
+     *
+     * @param os Output stream of the snapshot.
+     */
+    void save(ostream& os) {
+        this->model.save(os);
+        for (auto& shardModel : this->shardModels)
+            shardModel.save(os);
+    }
+
+    /**
+     * @brief Restores the trained classifier from a binary snapshot written by save.
+     *
+     * @param is Input stream of the snapshot.
+     */
+    void load(istream& is) {
+        this->model.load(is);
+        allocateShardModels();
+        for (auto& shardModel : this->shardModels)
+            shardModel.load(is);
     }
 
     /**
@@ -201,9 +796,17 @@ public:
      * @param output The output label to train the model with.
      */
     void fit(vector<float> input, int output) {
-        auto in = vector<vector<double>>{ vector<double>(input.begin(), input.end()) };
-        auto out = vector<int>{ output };
-        this->model.fit(in, out);
+        fitOne(input, output);
+    }
+
+    /**
+     * @brief Fits the SVM model online with a single input-output pair, without allocating memory.
+     *
+     * @param input The input data to train the model with.
+     * @param output The output label to train the model with.
+     */
+    void fitOne(span<const float> input, int output) {
+        this->model.fitOne(input, output);
     }
 
     /**
@@ -215,8 +818,37 @@ public:
      * @return The predicted output.
      */
     int predict(vector<float> input) {
-        auto in = vector<vector<double>>{ vector<double>(input.begin(), input.end()) };
-        return this->model.predict(in)[0];
+        return predictOne(input);
+    }
+
+    /**
+     * @brief Predicts the output for a single input, without allocating memory.
+     *
+     * @param input The input data to predict the output for.
+     * @return The predicted output.
+     */
+    int predictOne(span<const float> input) {
+        return this->model.predictOne(input);
+    }
+
+    /**
+     * @brief Predicts the output for the active features of a sparse encoded input, without allocating memory.
+     *
+     * @param features The indices of the active features of the input.
+     * @return The predicted output.
+     */
+    int predictSparse(span<const int> features) {
+        return this->model.predictSparse(features);
+    }
+
+    /**
+     * @brief Fits the SVM model online with the active features of a sparse encoded input, without allocating memory.
+     *
+     * @param features The indices of the active features of the input.
+     * @param output The output label to train the model with.
+     */
+    void fitSparse(span<const int> features, int output) {
+        this->model.fitSparse(features, output);
     }
 
     /**
@@ -225,6 +857,20 @@ public:
      * This method runs the SVM model on the input data, comparing the predicted outputs with the actual ones,
      * and calculating various performance metrics such as hit rate and miss rates.
      *
+     * By default, the model is trained synchronously after every mispredicted access. With more than one sample per
+     * mini-batch or an update delay, the mispredicted samples are accumulated instead, and each mini-batch is applied
+     * once it is full and updateDelay more accesses have been predicted (as a hardware update pipeline would do).
+     * The samples that are still pending at the end of the data are applied then.
+     *
+     * With more than one shard, the accesses are also partitioned among the shards, whose models predict and are
+     * trained in parallel with their accesses. The hit rate is then the aggregated one of the shards, and the hit
+     * rate of the shared model over all the accesses is reported as the sequential baseline.
+     *
+     * With a prefetch simulator, the next accesses of the instruction of every access are predicted once the model
+     * has been trained with it (see predictNextAccesses) and issued as prefetches, in the same pass. The access
+     * observer (if any) is notified of every access in the order of the trace too. With either of them, the shards
+     * are simulated in that order, instead of in parallel.
+     *
      * @param initialize Flag to specify whether to initialize the model before running the simulation.
      * @return A shared pointer to the prediction results and costs.
      */
@@ -239,60 +885,112 @@ public:
 			this->initializeModel();
 
 		}
+		this->allocateModelTables();
+		if (this->prefetchSimulator != nullptr) {
+			if (initialize) this->prefetchSimulator->reset();
+			else this->prefetchSimulator->resetCounters();
+		}
 
 		numHits = 0;
 		hitRate = 0.0;
 
-		for (int i = 0; i < inputData.size(); i++) {
-			vector<float> input = vector<float>(inputData[i].begin(), inputData[i].end());
-			int output = outputData[i];
-			auto isInputPredictable = predictableInputsMask[i];
-			auto inputBufferMiss = inputBufferMissesMask[i];
-			auto dictionaryMiss = dictionaryMissesMask[i];
+		for (int i = 0; i < outputData.size(); i++) {
+			if (dictionaryMissesMask[i]) numDictionaryMisses++;
+			if (inputBufferMissesMask[i]) numCacheMisses++;
+		}
 
-			int predictedOutput = -1;
-			if(isInputPredictable)
-				predictedOutput = predict(input);
+		// The predictions ahead are scored against the next accesses of the instruction of each access:
+		bool isPredictingNextAccesses = this->predictsNextAccesses();
+		if ((this->predictionDegree > 1 || isPredictingNextAccesses) && this->inputInstructions.size() == this->outputData.size())
+			this->nextInstructionAccesses = findNextInstructionAccesses(this->inputInstructions);
+		LookaheadCounters lookahead(this->predictionDegree > 1 ? this->predictionDegree : 0);
+
+		if (isPredictingNextAccesses && (this->nextInstructionAccesses.size() != outputData.size() ||
+			this->lastAccesses.size() != outputData.size() ||
+			(this->prefetchSimulator != nullptr && this->accesses.size() != outputData.size()))) {
+			string msg = "ERROR: The accesses imported by the SVM do not allow to prefetch its predictions!\n";
+			std::cout << msg;
+			throw std::invalid_argument(msg);
+		}
 
-			bool predictionMiss = (output != predictedOutput);
+		SimulationOptions options = getSimulationOptions();
+		bool isSharded = this->numShards > 1 && this->inputInstructions.size() == this->outputData.size();
+		if (!isSharded) {
+			ModelStream stream;
+			stream.model = &this->model;
+			stream.lookahead = lookahead;
+			stream.predictsNextAccesses = isPredictingNextAccesses;
+			stream.classDeltas = vector<L64b>(this->numClasses, 0);
+			simulateStream(stream, nullptr, options, true);
+			numHits = stream.numHits;
+			lookahead = stream.lookahead;
+		}
+		else {
+			// The accesses are partitioned by shard, keeping their order:
+			vector<int> accessShards = vector<int>(outputData.size());
+			vector<vector<int>> shardIndices = vector<vector<int>>(this->numShards);
+			for (int i = 0; i < outputData.size(); i++) {
+				accessShards[i] = getShard(this->inputInstructions[i]);
+				shardIndices[accessShards[i]].push_back(i);
+			}
 
-			// If thre was a miss, the fitting is performed with the input and output sample:
-			bool performFitting = !inputBufferMiss && (predictionMiss || dictionaryMiss);
-			if (performFitting) {
-				fit(input, output);
+			// The sequential baseline (with the shared model) and every shard are simulated:
+			vector<ModelStream> streams = vector<ModelStream>(this->numShards + 1);
+			streams[0].model = &this->model;
+			for (int s = 0; s < this->numShards; s++)
+				streams[s + 1].model = &this->shardModels[s];
+			for (auto& stream : streams)
+				stream.lookahead = lookahead;
+
+			if (this->accessObserver == nullptr && this->prefetchSimulator == nullptr) {
+				// The streams are independent, so they are simulated in parallel:
+#pragma omp parallel for schedule(dynamic,1)
+				for (int s = 0; s <= this->numShards; s++)
+					simulateStream(streams[s], s == 0 ? nullptr : &shardIndices[s - 1], options, false);
 			}
-			
-			bool hit = isInputPredictable && !dictionaryMiss && !inputBufferMiss && !predictionMiss;
-			if (hit)
-				numHits++;
-
-			if (dictionaryMiss) numDictionaryMisses++;
-			if (inputBufferMiss) numCacheMisses++;
-				
-
-			if (i % numPartsToPrint == 0) {
-				string in = "";
-				for (auto e : input)
-					in += to_string((e - 1.0) * numInputClasses) + ", ";
-				std::cout << in << " -> " << output << " vs " << predictedOutput << std::endl;
-				std::cout << "Hit rate: " << (double)numHits / (i + 1) << " ; " << ((double)i) / inputData.size() << std::endl;
+			else {
+				// The accesses are completed in the order of the trace, so each one is dispatched to its shard in order
+				// (only the shards predict the next accesses, the sequential baseline is just scored):
+				for (int s = 0; s < this->numShards; s++) {
+					streams[s + 1].predictsNextAccesses = isPredictingNextAccesses;
+					streams[s + 1].classDeltas = vector<L64b>(this->numClasses, 0);
+				}
+				for (int i = 0; i < outputData.size(); i++) {
+					simulateAccess(streams[0], i, options, false);
+					auto& stream = streams[accessShards[i] + 1];
+					bool hit = simulateAccess(stream, i, options, false);
+					completeAccess(stream, i, hit);
+				}
+				for (auto& stream : streams)
+					finishStream(stream, options);
 			}
 
+			long numSequentialHits = streams[0].numHits;
+			for (int s = 0; s < this->numShards; s++) {
+				numHits += streams[s + 1].numHits;
+				lookahead.add(streams[s + 1].lookahead);
+			}
+			resultsAndCosts.numShards = this->numShards;
+			resultsAndCosts.sequentialHitRate = ((double)numSequentialHits) / outputData.size();
 		}
 
-		hitRate = ((double)numHits) / inputData.size();
+		hitRate = ((double)numHits) / outputData.size();
 
 		resultsAndCosts.hitRate = hitRate;
-		resultsAndCosts.dictionaryMissRate = numDictionaryMisses / inputData.size();
-		resultsAndCosts.cacheMissRate = numCacheMisses / inputData.size();
+		resultsAndCosts.dictionaryMissRate = numDictionaryMisses / outputData.size();
+		resultsAndCosts.cacheMissRate = numCacheMisses / outputData.size();
 		resultsAndCosts.modelMemoryCost = getModelMemoryCosts();
+		resultsAndCosts.lookahead = lookahead.getResults(outputData.size());
+		if (this->prefetchSimulator != nullptr)
+			resultsAndCosts.prefetch = this->prefetchSimulator->getResults();
 		return shared_ptr<PredictResultsAndCosts>((PredictResultsAndCosts*) new BuffersSVMPredictResultsAndCosts(resultsAndCosts));
 	}
     /**
      * @brief Calculates the memory cost of the SVM model.
      *
      * This method calculates the total memory cost required by the model, based on the number of SVM classifiers
-     * and the number of features for each classifier. It returns the total memory cost in bytes.
+     * and the number of features for each classifier, with the size of the weights of the backend of the classifier.
+     * A sharded predictor has a whole model per shard. It returns the total memory cost in bytes.
      *
      * @return The total memory cost in bytes.
      */
@@ -300,7 +998,9 @@ public:
         int numSVMs = this->model.SVMsTable.size(); ///< Number of SVM classifiers in the model.
         int numElements = this->model.numFeatures + 1; ///< Number of elements per SVM (including the bias term).
 
-        return numElements * sizeof(float) * numSVMs;
+        int numModels = this->numShards > 1 ? this->numShards : 1; ///< Number of models (one per shard).
+
+        return numElements * this->model.getWeightSize() * numSVMs * numModels;
         // For now, we return the total number of bytes required for storing the model's weights and parameters.
     }
 
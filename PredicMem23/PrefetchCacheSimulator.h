@@ -0,0 +1,329 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//    Copyright (c) 2024  Pablo Snchez Cuevas                    //
+//                                                                             //
+//    This file is part of PredicMem23.                                            //
+//                                                                             //
+//    PredicMem23 is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by     //
+//    the Free Software Foundation, either version 3 of the License, or        //
+//    (at your option) any later version.                                      //
+//                                                                             //
+//    PredicMem23 is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the              //
+//    GNU General Public License for more details.                             //
+//                                                                             //
+//    You should have received a copy of the GNU General Public License        //
+//    along with PredicMem23. If not, see <
+// http://www.gnu.org/licenses/>.
+//
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <vector>
+#include "Global.h"
+
+using namespace std;
+
+/**
+ * @brief DataCacheModel Class that implements a set-associative data cache with LRU replacement over a flat array.
+ *
+ * The blocks of a set are contiguous in a single vector, so a lookup scans numWays adjacent blocks and nothing is
+ * allocated per access. Each block keeps its line, the time of its last use (0 for an invalid block), the time at which
+ * it arrives if it was prefetched, and whether it was prefetched and not demanded yet.
+ *
+ * @tparam A Type of access.
+ */
+template<typename A>
+class DataCacheModel {
+public:
+    /**
+     * @brief Block of the cache.
+     */
+    struct Block {
+        A line = 0; ///< Line (access without the offset bits).
+        L64bu lastUse = 0; ///< Time of the last use (0 if the block is invalid).
+        L64bu readyTime = 0; ///< Time at which the line arrives (0 if it is not a prefetch in flight).
+        bool isPrefetched = false; ///< Whether the line was prefetched and has not been demanded yet.
+    };
+
+    int numIndexBits = 0; ///< Number of index bits.
+    int numWays = 0; ///< Number of ways (0 for no cache).
+    vector<Block> blocks; ///< Blocks of every set, with the ways of each set contiguous.
+    L64bu numUses = 0; ///< Number of uses, which orders the blocks by recency.
+
+    /**
+     * @brief Constructor.
+     * @param numIndexBits Number of index bits.
+     * @param numWays Number of ways (0 for no cache).
+     */
+    DataCacheModel(int numIndexBits = 0, int numWays = 0) {
+        this->numIndexBits = numIndexBits;
+        this->numWays = numWays;
+        this->blocks = vector<Block>(((size_t)1 << numIndexBits) * numWays);
+    }
+
+    /**
+     * @brief Whether the cache exists.
+     * @return True if it has some ways.
+     */
+    bool isEnabled() const { return this->numWays > 0; }
+
+    /**
+     * @brief Find the block of a line.
+     * @param line The line to look up.
+     * @return The block of the line (-1 if it is missing).
+     */
+    long find(A line) const {
+        long first = (long)(line & (((A)1 << this->numIndexBits) - 1)) * this->numWays;
+        for (long b = first; b < first + this->numWays; b++) {
+            if (this->blocks[b].lastUse != 0 && this->blocks[b].line == line)
+                return b;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Mark a block as the most recently used of its set.
+     * @param block The block.
+     */
+    void touch(long block) {
+        this->blocks[block].lastUse = ++this->numUses;
+    }
+
+    /**
+     * @brief Find the block to replace for a line (an invalid one if any, otherwise the least recently used).
+     * @param line The line to insert.
+     * @return The victim block, whose previous contents are left for the caller to inspect.
+     */
+    long findVictim(A line) const {
+        long first = (long)(line & (((A)1 << this->numIndexBits) - 1)) * this->numWays;
+        long victim = first;
+        for (long b = first; b < first + this->numWays; b++) {
+            if (this->blocks[b].lastUse < this->blocks[victim].lastUse)
+                victim = b;
+        }
+        return victim;
+    }
+
+    /**
+     * @brief Insert a line into a block, as the most recently used of its set.
+     * @param block The block (see findVictim).
+     * @param line The line.
+     * @param isPrefetched Whether the line is prefetched.
+     * @param readyTime Time at which the line arrives.
+     */
+    void fill(long block, A line, bool isPrefetched = false, L64bu readyTime = 0) {
+        Block& b = this->blocks[block];
+        b.line = line;
+        b.isPrefetched = isPrefetched;
+        b.readyTime = readyTime;
+        touch(block);
+    }
+
+    /**
+     * @brief Invalidate every block.
+     */
+    void clear() {
+        std::fill(this->blocks.begin(), this->blocks.end(), Block());
+        this->numUses = 0;
+    }
+};
+
+/**
+ * @brief PrefetchCacheSimulator Class that feeds the predicted accesses as prefetches into an L1 and an optional L2.
+ *
+ * It is driven by the simulation loop of a predictor, in the same pass: every access of the trace is demanded with
+ * access, and the predictions made after it are issued with prefetch. The prefetches fill both levels, and the L1
+ * block remembers that it was prefetched and when it arrives (prefetchLatency accesses later, as the trace has no
+ * timing). The first demand of a prefetched line is a useful prefetch if it has arrived, and a late one otherwise
+ * (counted as an L1 miss, as the access waits for the line). Prefetched lines evicted before being demanded are
+ * useless. A copy of the caches fed only with the demands runs alongside, so the miss reduction is measured in the
+ * same pass, and the L1 misses of lines that this copy keeps are the pollution caused by the prefetches.
+ *
+ * @tparam A Type of access.
+ */
+template<typename A>
+class PrefetchCacheSimulator {
+protected:
+    L64bu time = 0; ///< Number of accesses demanded so far.
+
+    long numAccesses = 0; ///< Number of accesses demanded since the counters were reset.
+    long numL1Misses = 0; ///< Number of L1 misses with the prefetches.
+    long numL2Misses = 0; ///< Number of L2 misses with the prefetches.
+    long numBaselineL1Misses = 0; ///< Number of L1 misses without prefetches.
+    long numBaselineL2Misses = 0; ///< Number of L2 misses without prefetches.
+    long numPrefetches = 0; ///< Number of prefetches issued (those of lines already in the L1 are dropped).
+    long numUsefulPrefetches = 0; ///< Number of prefetched lines demanded after their arrival.
+    long numLatePrefetches = 0; ///< Number of prefetched lines demanded while still in flight.
+    long numUselessPrefetches = 0; ///< Number of prefetched lines evicted from the L1 before being demanded.
+    long numPollutionMisses = 0; ///< Number of L1 misses of lines that the L1 without prefetches keeps.
+
+    /**
+     * @brief Demand a line from the L2 after an L1 miss, inserting it if it is missing.
+     * @param l2 The L2.
+     * @param line The line.
+     * @return True if the line misses in the L2.
+     */
+    static bool demandL2(DataCacheModel<A>& l2, A line) {
+        if (!l2.isEnabled())
+            return true;
+        long block = l2.find(line);
+        if (block >= 0) {
+            l2.touch(block);
+            return false;
+        }
+        l2.fill(l2.findVictim(line), line);
+        return true;
+    }
+
+public:
+    int numLineBits = 6; ///< Number of bits of the offset of a line.
+    L64bu prefetchLatency = 10; ///< Number of accesses until a prefetched line arrives.
+    DataCacheModel<A> l1; ///< L1 fed with the demands and the prefetches.
+    DataCacheModel<A> l2; ///< L2 fed with the demands and the prefetches.
+    DataCacheModel<A> baselineL1; ///< L1 fed only with the demands.
+    DataCacheModel<A> baselineL2; ///< L2 fed only with the demands.
+
+    /**
+     * @brief Constructor.
+     * @param params Parameters of the caches.
+     */
+    PrefetchCacheSimulator(PrefetchCacheParameters params) {
+        this->numLineBits = params.numLineBits;
+        this->prefetchLatency = params.prefetchLatency;
+        this->l1 = DataCacheModel<A>(params.numL1IndexBits, params.numL1Ways);
+        this->l2 = DataCacheModel<A>(params.numL2IndexBits, params.numL2Ways);
+        this->baselineL1 = DataCacheModel<A>(params.numL1IndexBits, params.numL1Ways);
+        this->baselineL2 = DataCacheModel<A>(params.numL2IndexBits, params.numL2Ways);
+    }
+
+    /**
+     * @brief Empty the caches and reset the counters.
+     */
+    void reset() {
+        this->l1.clear();
+        this->l2.clear();
+        this->baselineL1.clear();
+        this->baselineL2.clear();
+        this->time = 0;
+        resetCounters();
+    }
+
+    /**
+     * @brief Reset the counters, keeping the contents of the caches (e.g. for the next part of a trace).
+     */
+    void resetCounters() {
+        this->numAccesses = 0;
+        this->numL1Misses = 0;
+        this->numL2Misses = 0;
+        this->numBaselineL1Misses = 0;
+        this->numBaselineL2Misses = 0;
+        this->numPrefetches = 0;
+        this->numUsefulPrefetches = 0;
+        this->numLatePrefetches = 0;
+        this->numUselessPrefetches = 0;
+        this->numPollutionMisses = 0;
+    }
+
+    /**
+     * @brief Demand an access of the trace.
+     * @param access The access.
+     */
+    void access(A access) {
+        this->time++;
+        this->numAccesses++;
+        A line = access >> this->numLineBits;
+
+        bool isBaselineL1Hit = true;
+        long block = this->baselineL1.find(line);
+        if (block >= 0) {
+            this->baselineL1.touch(block);
+        }
+        else {
+            isBaselineL1Hit = false;
+            this->numBaselineL1Misses++;
+            if (demandL2(this->baselineL2, line))
+                this->numBaselineL2Misses++;
+            this->baselineL1.fill(this->baselineL1.findVictim(line), line);
+        }
+
+        block = this->l1.find(line);
+        if (block >= 0) {
+            auto& b = this->l1.blocks[block];
+            if (b.isPrefetched) {
+                b.isPrefetched = false;
+                if (b.readyTime > this->time) {
+                    this->numLatePrefetches++;
+                    this->numL1Misses++;
+                }
+                else {
+                    this->numUsefulPrefetches++;
+                }
+            }
+            this->l1.touch(block);
+            return;
+        }
+
+        this->numL1Misses++;
+        if (isBaselineL1Hit)
+            this->numPollutionMisses++;
+        if (demandL2(this->l2, line))
+            this->numL2Misses++;
+        block = this->l1.findVictim(line);
+        if (this->l1.blocks[block].isPrefetched)
+            this->numUselessPrefetches++;
+        this->l1.fill(block, line);
+    }
+
+    /**
+     * @brief Issue a predicted access as a prefetch (dropped if its line is already in the L1).
+     * @param access The predicted access.
+     */
+    void prefetch(A access) {
+        A line = access >> this->numLineBits;
+        if (this->l1.find(line) >= 0)
+            return;
+
+        this->numPrefetches++;
+        if (this->l2.isEnabled()) {
+            long block = this->l2.find(line);
+            if (block >= 0)
+                this->l2.touch(block);
+            else
+                this->l2.fill(this->l2.findVictim(line), line);
+        }
+        long block = this->l1.findVictim(line);
+        if (this->l1.blocks[block].isPrefetched)
+            this->numUselessPrefetches++;
+        this->l1.fill(block, line, true, this->time + this->prefetchLatency);
+    }
+
+    /**
+     * @brief Get the rates of the accesses demanded since the counters were reset.
+     * @return The rates.
+     */
+    PrefetchResults getResults() const {
+        PrefetchResults res;
+        res.isSimulated = true;
+        res.isL2Simulated = this->l2.isEnabled();
+        double numAccesses = this->numAccesses > 0 ? (double)this->numAccesses : 1.0;
+        double numPrefetches = this->numPrefetches > 0 ? (double)this->numPrefetches : 1.0;
+        res.l1MissRate = this->numL1Misses / numAccesses;
+        res.baselineL1MissRate = this->numBaselineL1Misses / numAccesses;
+        res.l1MissReduction = this->numBaselineL1Misses > 0 ?
+            (double)(this->numBaselineL1Misses - this->numL1Misses) / this->numBaselineL1Misses : 0.0;
+        res.l2MissRate = this->numL2Misses / numAccesses;
+        res.baselineL2MissRate = this->numBaselineL2Misses / numAccesses;
+        res.l2MissReduction = this->numBaselineL2Misses > 0 ?
+            (double)(this->numBaselineL2Misses - this->numL2Misses) / this->numBaselineL2Misses : 0.0;
+        res.prefetchRate = this->numPrefetches / numAccesses;
+        res.usefulPrefetchRate = this->numUsefulPrefetches / numPrefetches;
+        res.latePrefetchRate = this->numLatePrefetches / numPrefetches;
+        res.uselessPrefetchRate = this->numUselessPrefetches / numPrefetches;
+        res.pollutingPrefetchRate = this->numPollutionMisses / numPrefetches;
+        return res;
+    }
+};
@@ -11,7 +11,10 @@
 /// - SVMSGDClassifier: Stochastic Gradient Descent-based SVM.
 /// - MultiSVMClassifier: Base class for multi-class SVMs.
 /// - MultiSVMClassifierOneToOne: One-vs-One multi-class SVM.
-/// - MultiSVMClassifierOneToAll: One-vs-All multi-class SVM.
+/// - MultiSVMClassifierOneToAllT: One-vs-All multi-class SVM, templated on the type of its weights.
+/// - SVMWeightFormat: Numeric formats (floating and fixed point) of the weights.
+/// - AlignedAllocator: Allocator of aligned memory for the weights.
+/// - Xoshiro128PlusPlus: Seedable pseudo-random generator of each classifier.
 ///
 /// @section LICENSE
 /// Copyright (c) 2024 Pablo Snchez Cuevas
@@ -36,10 +39,105 @@
 #define SVM_CLASS_H
 
 #include <vector>
+#include <span>
+#include <iostream>
+#include <new>
+#include <limits>
+#include <cmath>
+#include <cstdint>
 #include <time.h>
 
 using namespace std;
 
+/**
+ * @brief Allocator of memory aligned to a given number of bytes (e.g., a cache line or a SIMD register).
+ * @tparam V Type of the elements.
+ * @tparam Alignment Alignment in bytes.
+ */
+template<typename V, size_t Alignment = 64>
+struct AlignedAllocator {
+    typedef V value_type;
+
+    template<typename U>
+    struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+    AlignedAllocator() noexcept {}
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    V* allocate(size_t n) {
+        return (V*)::operator new(n * sizeof(V), std::align_val_t(Alignment));
+    }
+
+    void deallocate(V* p, size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
+
+/// @brief Vector of doubles aligned to a cache line.
+typedef vector<double, AlignedAllocator<double>> AlignedDoubleVector;
+
+/**
+ * @brief Fast seedable pseudo-random generator (xoshiro128++), owned by each classifier.
+ *
+ * It replaces the global srand/rand, so that classifiers trained in different threads neither share state nor
+ * contend for it, and their results only depend on their own seeds. The state is initialized from the seed
+ * with SplitMix64.
+ */
+class Xoshiro128PlusPlus {
+private:
+    uint32_t s[4]; ///< State of the generator.
+
+    static uint32_t rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+
+public:
+    /**
+     * @brief Constructor.
+     * @param seed Seed of the generator.
+     */
+    Xoshiro128PlusPlus(uint64_t seed = 0) {
+        this->seed(seed);
+    }
+
+    /**
+     * @brief Restart the generator from a seed.
+     * @param seed Seed of the generator.
+     */
+    void seed(uint64_t seed) {
+        for (int i = 0; i < 4; i += 2) {
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z = z ^ (z >> 31);
+            s[i] = (uint32_t)z;
+            s[i + 1] = (uint32_t)(z >> 32);
+        }
+    }
+
+    /**
+     * @brief Draw the next pseudo-random number.
+     * @return A uniformly distributed 32-bit number.
+     */
+    uint32_t operator()() {
+        uint32_t result = rotl(s[0] + s[3], 7) + s[0];
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+};
+
 /// @brief Base class for Support Vector Machine (SVM) classifiers.
 class SVMClassifier {
 protected:
@@ -49,7 +147,7 @@ protected:
 public:
     double c; ///< Regularization parameter.
     unsigned int epochs; ///< Number of training epochs.
-    unsigned int seed; ///< Random seed for initialization.
+    unsigned int seed; ///< Seed of the random draws of the samples (each training restarts from it).
 
     /**
      * @brief Default constructor.
@@ -91,6 +189,20 @@ public:
      */
     vector<int> predict(vector<vector<double>>& data);
 
+    /**
+     * @brief Compute the signed distance of a single sample to the decision boundary (w * x - b).
+     * @param x Sample to classify.
+     * @return Decision value of the sample.
+     */
+    double decisionValue(span<const float> x);
+
+    /**
+     * @brief Predict the label of a single sample, without allocating memory.
+     * @param x Sample to classify.
+     * @return Predicted label (+1 or -1), as predict would return for it.
+     */
+    int predictOne(span<const float> x);
+
     /**
      * @brief Calculate classification accuracy.
      * @param label True labels.
@@ -106,12 +218,42 @@ public:
      * @return Accuracy value.
      */
     double accuracy(vector<vector<double>>& data, vector<int>& label);
+
+    /**
+     * @brief Write the weights and hyperparameters into a binary snapshot.
+     * @param os Output stream of the snapshot.
+     */
+    void save(ostream& os);
+
+    /**
+     * @brief Restore the weights and hyperparameters from a binary snapshot written by save.
+     * @param is Input stream of the snapshot.
+     */
+    void load(istream& is);
 };
 
+/**
+ * @brief Compute the average hinge-loss gradients of a batch of samples (see svm_classifier.cpp).
+ * @param w Weights of the classifier.
+ * @param b Bias of the classifier.
+ * @param x Training data.
+ * @param y Labels of the training data.
+ * @param batch Indices of the samples of the batch.
+ * @param c Regularization parameter.
+ * @param dw Output weight gradients.
+ * @param pointer_db Output bias gradient.
+ * @param rng Generator of the noise.
+ * @param noiseFactor Relative magnitude of the noise (0 to disable it).
+ */
+void computeGradients(const vector<double>& w, double b, const vector<vector<double>>& x, const vector<int>& y,
+    span<const unsigned int> batch, double c, vector<double>& dw, double* pointer_db, Xoshiro128PlusPlus& rng,
+    double noiseFactor);
+
 /// @brief SVM classifier trained using stochastic gradient descent (SGD).
 class SVMSGDClassifier : public SVMClassifier {
 public:
     double learningRate; ///< Learning rate for SGD.
+    double gradientNoise = 0.0; ///< Relative magnitude of the noise added to the gradients by fit (0 to disable it).
 
     /**
      * @brief Default constructor.
@@ -140,12 +282,33 @@ public:
      */
     void fit(vector<vector<double>>& data, vector<int>& label);
 
+    /**
+     * @brief Train the SVM online with a single sample, without allocating memory.
+     *
+     * The updates are the same ones performed by fit with a one-sample dataset.
+     * @param x Training sample.
+     * @param label Label of the sample (+1, -1, or 0 to skip it).
+     */
+    void fitOne(span<const float> x, int label);
+
     /**
      * @brief Compute distances from data points to the decision boundary.
      * @param data Data to classify.
      * @return Distances from the decision boundary.
      */
     vector<double> computeDistanceToPlane(vector<vector<double>>& data);
+
+    /**
+     * @brief Write the weights and hyperparameters into a binary snapshot.
+     * @param os Output stream of the snapshot.
+     */
+    void save(ostream& os);
+
+    /**
+     * @brief Restore the weights and hyperparameters from a binary snapshot written by save.
+     * @param is Input stream of the snapshot.
+     */
+    void load(istream& is);
 };
 
 /// @brief Types of multi-class SVM classifiers.
@@ -155,7 +318,10 @@ enum class MultiSVMClassifierType { OneToOne, OneToAll };
 class MultiSVMClassifier : public SVMSGDClassifier {
 private:
     vector<double> w; ///< Weight vector for multi-class classification.
-    unsigned int seed; ///< Random seed for initialization.
+    unsigned int seed; ///< Seed of the classifier, from which the seeds of the binary classifiers are drawn.
+
+protected:
+    Xoshiro128PlusPlus rng; ///< Generator of the seeds of the binary classifiers.
 
 public:
     int numClasses; ///< Number of classes.
@@ -174,8 +340,9 @@ public:
      * @param c Regularization parameter.
      * @param epochs Number of training epochs.
      * @param learningRate Learning rate for SGD.
+     * @param seed Seed of the classifier (the same seed gives the same results, regardless of the thread).
      */
-    MultiSVMClassifier(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate);
+    MultiSVMClassifier(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate, unsigned int seed = 0);
 
     /**
      * @brief Initialize weights with random values.
@@ -196,6 +363,28 @@ public:
      * @param label Corresponding labels for the training data.
      */
     void fit(vector<vector<double>>& data, vector<int>& label);
+
+    /**
+     * @brief Get the number of bytes of each weight, for the memory costs.
+     * @return Size of a weight in bytes.
+     */
+    size_t getWeightSize() {
+        return sizeof(double);
+    }
+
+    /**
+     * @brief Write the state of all the binary classifiers into a binary snapshot.
+     * @param os Output stream of the snapshot.
+     */
+    void save(ostream& os);
+
+    /**
+     * @brief Restore the state of all the binary classifiers from a binary snapshot written by save.
+     *
+     * The snapshot must have been taken from a classifier with the same number of features and classes.
+     * @param is Input stream of the snapshot.
+     */
+    void load(istream& is);
 };
 
 /// @brief One-vs-One multi-class SVM classifier.
@@ -213,8 +402,9 @@ public:
      * @param c Regularization parameter.
      * @param epochs Number of training epochs.
      * @param learningRate Learning rate for SGD.
+     * @param seed Seed of the classifier.
      */
-    MultiSVMClassifierOneToOne(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate);
+    MultiSVMClassifierOneToOne(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate, unsigned int seed = 0);
 
     /**
      * @brief Predict labels for a given dataset.
@@ -229,15 +419,224 @@ public:
      * @param label Corresponding labels for the training data.
      */
     void fit(vector<vector<double>>& data, vector<int>& label);
+
+    /**
+     * @brief Predict the class of a single sample, without allocating memory.
+     * @param x Sample to classify.
+     * @return Predicted class.
+     */
+    int predictOne(span<const float> x);
+
+    /**
+     * @brief Train the one-vs-one multi-class SVM online with a single sample, without allocating memory.
+     * @param x Training sample.
+     * @param label Class of the sample.
+     */
+    void fitOne(span<const float> x, int label);
+
+private:
+    vector<int> predictionsHistogram; ///< Votes of each class, reused by predictOne.
 };
 
-/// @brief One-vs-All multi-class SVM classifier.
-class MultiSVMClassifierOneToAll : public MultiSVMClassifier {
+/**
+ * @brief Fixed-point format of the weights of a quantized SVM backend.
+ *
+ * The values are stored as integers with a given number of fractional bits, rounded to the nearest value and
+ * saturated to the range of the storage type, as a hardware implementation would do.
+ * @tparam W Type of the stored values.
+ * @tparam Acc Type of the accumulator of the dot products (wide enough for the products of two values).
+ * @tparam FractionalBits Number of fractional bits.
+ */
+template<typename W, typename Acc, int FractionalBits>
+struct SVMFixedPointFormat {
+    typedef Acc Accumulator; ///< Type of the accumulator of the dot products.
+    static const int fractionalBits = FractionalBits; ///< Number of fractional bits of the stored values.
+
+    /**
+     * @brief Round a real value to the nearest representable one, saturating it to the range of W.
+     * @param v Real value.
+     * @return The stored value.
+     */
+    static W quantize(double v) {
+        double scaled = std::round(v * (double)(1 << FractionalBits));
+        if (scaled > (double)std::numeric_limits<W>::max()) return std::numeric_limits<W>::max();
+        if (scaled < (double)std::numeric_limits<W>::min()) return std::numeric_limits<W>::min();
+        return (W)scaled;
+    }
+
+    /**
+     * @brief Get the real value of a stored value.
+     * @param v Stored value.
+     * @return The real value.
+     */
+    static double toReal(W v) {
+        return (double)v / (double)(1 << FractionalBits);
+    }
+
+    /**
+     * @brief Get the real value of an accumulated dot product (with twice the fractional bits).
+     * @param v Accumulated value.
+     * @return The real value.
+     */
+    static double accumulatorToReal(Acc v) {
+        return (double)v / ((double)(1 << FractionalBits) * (double)(1 << FractionalBits));
+    }
+};
+
+/**
+ * @brief Numeric format of the weights of an SVM backend.
+ *
+ * The floating-point backends store the values as they are computed, accumulating in their own precision.
+ * @tparam W Type of the weights.
+ */
+template<typename W>
+struct SVMWeightFormat {
+    typedef W Accumulator; ///< Type of the accumulator of the dot products.
+    static const int fractionalBits = 0; ///< Number of fractional bits of the stored values (none in floating point).
+
+    static W quantize(double v) { return (W)v; }
+    static double toReal(W v) { return (double)v; }
+    static double accumulatorToReal(Accumulator v) { return (double)v; }
+};
+
+/// @brief Q7.8 weights of 16 bits. The products need up to 31 bits, so they are accumulated in 64 bits.
+template<>
+struct SVMWeightFormat<int16_t> : SVMFixedPointFormat<int16_t, int64_t, 8> {};
+
+/// @brief Q3.4 weights of 8 bits, accumulated in 32 bits (each product needs at most 15 bits).
+template<>
+struct SVMWeightFormat<int8_t> : SVMFixedPointFormat<int8_t, int32_t, 4> {};
+
+/**
+ * @brief One-vs-All multi-class SVM classifier, templated on the type of its weights.
+ *
+ * The weights of all the binary classifiers are stored in a single aligned matrix, where the weights of every
+ * class for the same feature are contiguous (i.e., numClasses x numFeatures in column-major order, with the
+ * classes padded to classStride). A sample is then scored against all the classes in one pass over its features,
+ * and each class accumulates its dot product in the same order as a separate SVMSGDClassifier would do.
+ * The classifiers of SVMsTable only keep the hyperparameters.
+ *
+ * The samples are quantized to the format of the weights before being scored, and the dot products are
+ * accumulated in the accumulator of that format (see SVMWeightFormat). The SGD steps are computed in double, and
+ * their results are rounded and saturated back to the format of the weights.
+ * @tparam W Type of the weights (double, float, int16_t or int8_t).
+ */
+template<typename W>
+class MultiSVMClassifierOneToAllT : public MultiSVMClassifier {
+protected:
+    typedef SVMWeightFormat<W> Format; ///< Numeric format of the weights.
+    typedef typename Format::Accumulator Accumulator; ///< Type of the accumulator of the dot products.
+    typedef vector<W, AlignedAllocator<W>> AlignedWeightVector; ///< Vector of weights aligned to a cache line.
+
+    int classStride = 0; ///< Number of classes per row of the weight matrix, padded to a multiple of the SIMD width.
+    AlignedWeightVector weights; ///< Weight matrix (numFeatures rows of classStride weights).
+    AlignedWeightVector biases; ///< Bias term of each class.
+    AlignedWeightVector input; ///< Sample quantized to the format of the weights, reused by every sample.
+    vector<Accumulator, AlignedAllocator<Accumulator>> accumulators; ///< Dot products of each class, reused by every sample.
+    AlignedDoubleVector scores; ///< Decision values (w * x - b) of each class, reused by every sample.
+    AlignedDoubleVector gradientCoefficients; ///< c * label of the classes with active hinge loss (0 for the rest), reused by every sample.
+    AlignedDoubleVector batchCoefficients; ///< Gradient coefficients of every sample of a mini-batch (numSamples rows of classStride).
+    AlignedDoubleVector batchGradients; ///< Summed gradients of a mini-batch (a row for dense samples, the matrix for sparse ones).
+    vector<int> batchRows; ///< Rows of the matrix updated by a sparse mini-batch.
+    vector<char> isBatchRow; ///< Whether each row of the matrix is in batchRows.
+
+    /**
+     * @brief Compute the gradient coefficients of a sample of a mini-batch from the computed scores.
+     * @param sample Index of the sample in the mini-batch.
+     * @param label Class of the sample.
+     */
+    void computeBatchCoefficients(size_t sample, int label);
+
+    vector<unsigned int> classVersions; ///< Version of the weights of each class, increased when they are updated.
+    unsigned long long modelVersion = 1; ///< Version of the whole model, increased when any class is updated.
+    AlignedDoubleVector memoScores; ///< Memoized decision value of each class for each history (numHistories rows of classStride).
+    vector<unsigned int> memoClassVersions; ///< Version of each class when its memoized decision value was computed (0 if never).
+    vector<int> memoPredictions; ///< Memoized predicted class of each history.
+    vector<unsigned long long> memoModelVersions; ///< Version of the model when each prediction was memoized (0 if never).
+
+    /**
+     * @brief Invalidate the memoized decision values of a class, after its weights are updated.
+     * @param k Class whose weights were updated.
+     */
+    void invalidateClass(int k) {
+        this->classVersions[k]++;
+        this->modelVersion++;
+    }
+
+    /**
+     * @brief Invalidate the memoized decision values of the classes whose weights are changed by an SGD step.
+     * @param coefficients Gradient coefficients of the step (the weights of a class with a null one only change
+     * with the regularization term, which is null when c = 1).
+     */
+    void invalidateClasses(const double* coefficients) {
+        for (int k = 0; k < this->numClasses; k++)
+            if (coefficients[k] != 0.0 || this->c != 1.0)
+                invalidateClass(k);
+    }
+
+    /**
+     * @brief Forget all the memoized predictions (e.g., when the whole weight matrix is replaced).
+     */
+    void resetMemoization();
+
+    /**
+     * @brief Quantize a sample into input.
+     * @param x Sample.
+     */
+    template<typename X>
+    void quantizeInput(span<const X> x);
+
+    /**
+     * @brief Compute the decision values of all the classes for the quantized input into scores (fused GEMV kernel).
+     */
+    void computeScores();
+
+    /**
+     * @brief Compute the decision values of all the classes for a sparse binary sample into scores.
+     *
+     * Only the rows of the active features are read, so the cost does not depend on the total number of features.
+     * @param features Indices of the active features (with value 1, repeated indices are added again).
+     */
+    void computeSparseScores(span<const int> features);
+
+    /**
+     * @brief Pick the class predicted against the rest that is closest to its boundary, from the computed scores.
+     * @return Predicted class (0 if none of the classes is predicted).
+     */
+    int bestClassFromScores();
+
+    /**
+     * @brief Predict the class of a sample.
+     * @param x Sample to classify.
+     * @return Predicted class.
+     */
+    template<typename X>
+    int predictSample(span<const X> x);
+
+    /**
+     * @brief Train all the classifiers with a sample (one SGD step per epoch).
+     * @param x Training sample.
+     * @param label Class of the sample.
+     */
+    template<typename X>
+    void fitSample(span<const X> x, int label);
+
+    /**
+     * @brief Train the classifier of a class with a quantized sample (one SGD step).
+     *
+     * It only touches the given weights, so the classifiers of different classes can be trained concurrently.
+     * @param w Weights of the classifier (numFeatures contiguous values).
+     * @param b Bias of the classifier.
+     * @param x Quantized training sample.
+     * @param label Label of the sample for the classifier (-1 for its class, +1 for the rest).
+     */
+    void fitClass(W* w, W& b, const W* x, int label);
+
 public:
     /**
      * @brief Default constructor.
      */
-    MultiSVMClassifierOneToAll();
+    MultiSVMClassifierOneToAllT();
 
     /**
      * @brief Parameterized constructor.
@@ -246,8 +645,15 @@ public:
      * @param c Regularization parameter.
      * @param epochs Number of training epochs.
      * @param learningRate Learning rate for SGD.
+     * @param seed Seed of the classifier.
      */
-    MultiSVMClassifierOneToAll(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate);
+    MultiSVMClassifierOneToAllT(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate, unsigned int seed = 0);
+
+    /**
+     * @brief Initialize weights with their initial values.
+     * @param numFeatures Number of features in the data.
+     */
+    void initWeights(int numFeatures);
 
     /**
      * @brief Predict labels for a given dataset.
@@ -256,12 +662,129 @@ public:
      */
     vector<int> predict(vector<vector<double>>& data);
 
+    /**
+     * @brief Write the hyperparameters and the weight matrix into a binary snapshot.
+     * @param os Output stream of the snapshot.
+     */
+    void save(ostream& os);
+
+    /**
+     * @brief Restore the hyperparameters and the weight matrix from a binary snapshot written by save.
+     * @param is Input stream of the snapshot.
+     */
+    void load(istream& is);
+
+    /**
+     * @brief Get a weight of the classifier of a class.
+     * @param k Class of the classifier.
+     * @param j Feature of the weight.
+     * @return The real value of the weight.
+     */
+    double getWeight(int k, int j) {
+        return Format::toReal(weights[(size_t)j * classStride + k]);
+    }
+
+    /**
+     * @brief Get the bias of the classifier of a class.
+     * @param k Class of the classifier.
+     * @return The real value of the bias.
+     */
+    double getBias(int k) {
+        return Format::toReal(biases[k]);
+    }
+
+    /**
+     * @brief Get the number of bytes of each weight, for the memory costs.
+     * @return Size of a weight in bytes.
+     */
+    size_t getWeightSize() {
+        return sizeof(W);
+    }
+
     /**
      * @brief Train the one-vs-all multi-class SVM.
      * @param data Training data.
      * @param label Corresponding labels for the training data.
      */
     void fit(vector<vector<double>>& data, vector<int>& label);
+
+    /**
+     * @brief Predict the class of a single sample, without allocating memory.
+     * @param x Sample to classify.
+     * @return Predicted class.
+     */
+    int predictOne(span<const float> x);
+
+    /**
+     * @brief Train the one-vs-all multi-class SVM online with a single sample, without allocating memory.
+     * @param x Training sample.
+     * @param label Class of the sample.
+     */
+    void fitOne(span<const float> x, int label);
+
+    /**
+     * @brief Predict the class of a sparse binary sample (e.g., one-hot encoded), without allocating memory.
+     * @param features Indices of the active features of the sample.
+     * @return Predicted class.
+     */
+    int predictSparse(span<const int> features);
+
+    /**
+     * @brief Train the one-vs-all multi-class SVM online with a sparse binary sample, without allocating memory.
+     *
+     * Only the weights of the active features are updated, so the regularization term (1 - c) is not applied to the
+     * rest of them (it is null with the c = 1 of the predictor, and then the updates match the dense ones).
+     * @param features Indices of the active features of the sample.
+     * @param label Class of the sample.
+     */
+    void fitSparse(span<const int> features, int label);
+
+    /**
+     * @brief Train the one-vs-all multi-class SVM with a mini-batch of samples, without allocating memory once warm.
+     *
+     * The hinge losses of all the samples are computed with the same weights, and then the weights are updated once
+     * per epoch with the average of their gradients (as computeGradients does). A one-sample batch gives the same
+     * update as fitOne.
+     * @param x Training samples.
+     * @param labels Classes of the samples.
+     */
+    void fitBatch(span<const span<const float>> x, span<const int> labels);
+
+    /**
+     * @brief Train the one-vs-all multi-class SVM with a mini-batch of sparse binary samples.
+     *
+     * Same update as fitBatch, only over the rows of the features that are active in some sample of the batch.
+     * @param features Indices of the active features of each sample.
+     * @param labels Classes of the samples.
+     */
+    void fitSparseBatch(span<const span<const int>> features, span<const int> labels);
+
+    /**
+     * @brief Allocate a table to memoize the predictions of a number of distinct histories.
+     *
+     * The table keeps the predicted class of each history with the version of the model, and the decision value of
+     * each class with the version of that class, so after an update only the classes whose weights changed are
+     * scored again. The predictions are identical to the ones of predictOne. A table that already has the size is kept.
+     * @param numHistories Number of distinct histories (0 to free the table).
+     */
+    void enableMemoization(size_t numHistories);
+
+    /**
+     * @brief Predict the class of a sample, looking it up in the memoization table first.
+     * @param history Index of the history of the sample in the table (the same sample has to have the same index).
+     * @param x Sample to classify.
+     * @return Predicted class.
+     */
+    int predictMemoized(size_t history, span<const float> x);
 };
 
+/// @brief One-vs-All multi-class SVM with double weights (reference backend).
+typedef MultiSVMClassifierOneToAllT<double> MultiSVMClassifierOneToAll;
+/// @brief One-vs-All multi-class SVM with float32 weights.
+typedef MultiSVMClassifierOneToAllT<float> MultiSVMClassifierOneToAllFloat;
+/// @brief One-vs-All multi-class SVM with Q7.8 fixed-point weights of 16 bits.
+typedef MultiSVMClassifierOneToAllT<int16_t> MultiSVMClassifierOneToAllInt16;
+/// @brief One-vs-All multi-class SVM with Q3.4 fixed-point weights of 8 bits.
+typedef MultiSVMClassifierOneToAllT<int8_t> MultiSVMClassifierOneToAllInt8;
+
 #endif
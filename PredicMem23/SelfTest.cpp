@@ -0,0 +1,427 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//    Copyright (c) 2024  Pablo Snchez Cuevas                    //
+//                                                                             //
+//    This file is part of PredicMem23.                                            //
+//                                                                             //
+//    PredicMem23 is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by     //
+//    the Free Software Foundation, either version 3 of the License, or        //
+//    (at your option) any later version.                                      //
+//                                                                             //
+//    PredicMem23 is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the              //
+//    GNU General Public License for more details.                             //
+//                                                                             //
+//    You should have received a copy of the GNU General Public License        //
+//    along with PredicMem23. If not, see <
+// http://www.gnu.org/licenses/>.
+//
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "SVMClassifier.hpp"
+#include "DFCM.h"
+#include "KOrderDFCM.h"
+#include "CorrelationPredictor.h"
+#include "SelfTest.h"
+
+using namespace std;
+
+/**
+ * @brief Check a condition of a test, printing its description if it does not hold.
+ * @param condition The condition to check.
+ * @param description Description of the failure.
+ * @return 1 if the check failed, 0 otherwise.
+ */
+static int check(bool condition, const string& description) {
+	if (!condition)
+		std::cout << "FAILED: " << description << std::endl;
+	return condition ? 0 : 1;
+}
+
+/**
+ * @brief Draw a real number of a range, with a few decimals.
+ * @param rng Generator of the draws.
+ * @param min Lower bound of the range.
+ * @param max Upper bound of the range.
+ * @return The drawn number.
+ */
+static double randomReal(Xoshiro128PlusPlus& rng, double min, double max) {
+	return min + (max - min) * (double)(rng() % 100000) / 100000.0;
+}
+
+/**
+ * @brief Reference of computeGradients: the original implementation, where every sample computes its own gradient
+ * vector and adds it divided by the batch size (without noise).
+ */
+static void referenceGradients(const vector<double>& w, double b, const vector<vector<double>>& x, const vector<int>& y,
+	double c, vector<double>& dw, double* db) {
+	vector<double> resultingGradient_w = vector<double>(w.size(), 0);
+	double resultingGradient_b = 0.0;
+
+	for (size_t i = 0; i < x.size(); i++) {
+		vector<double> partialGradient_w = vector<double>(w.size(), 0);
+		double partialGradient_b = 0.0;
+		double dot_product = 0;
+		for (size_t j = 0; j < w.size(); j++)
+			dot_product += w[j] * x[i][j];
+
+		double distance = 1 - y[i] * (dot_product - b);
+		if (distance <= 0) {
+			for (size_t j = 0; j < w.size(); j++)
+				partialGradient_w[j] = w[j] * (1 - c);
+			partialGradient_b = 0.0;
+		}
+		else {
+			for (size_t j = 0; j < w.size(); j++)
+				partialGradient_w[j] = (w[j] * (1 - c)) - (c * y[i] * x[i][j]);
+			partialGradient_b = c * y[i];
+		}
+
+		for (size_t j = 0; j < w.size(); j++)
+			resultingGradient_w[j] += partialGradient_w[j] / x.size();
+		resultingGradient_b += partialGradient_b / x.size();
+	}
+
+	dw = resultingGradient_w;
+	*db = resultingGradient_b;
+}
+
+/**
+ * @brief computeGradients against the reference, over random batches of 1 to 8 samples.
+ *
+ * Without noise, the weight and bias gradients have to be bit-exact. With noise, the bias gradient is still exact,
+ * and each weight gradient moves at most by the noise factor times the norm of the gradient of each sample.
+ *
+ * @return Number of failed checks.
+ */
+static int testComputeGradients() {
+	int numFailed = 0;
+	Xoshiro128PlusPlus rng(1), noiseRng(2);
+	const double noiseFactor = 0.1;
+
+	for (int t = 0; t < 2000; t++) {
+		int numSamples = 1 + rng() % 8, numFeatures = 1 + rng() % 12;
+		vector<double> w(numFeatures);
+		for (auto& value : w)
+			value = randomReal(rng, -3, 3);
+		double b = randomReal(rng, -2, 2), c = randomReal(rng, 0.5, 1);
+		vector<vector<double>> x(numSamples, vector<double>(numFeatures));
+		vector<int> y(numSamples);
+		vector<unsigned int> batch(numSamples);
+		for (int i = 0; i < numSamples; i++) {
+			for (auto& value : x[i])
+				value = randomReal(rng, 0, 10);
+			y[i] = rng() % 2 ? 1 : -1;
+			batch[i] = i;
+		}
+		string name = " (case " + to_string(t) + ")";
+
+		vector<double> referenceDw, dw;
+		double referenceDb, db;
+		referenceGradients(w, b, x, y, c, referenceDw, &referenceDb);
+		computeGradients(w, b, x, y, batch, c, dw, &db, noiseRng, 0.0);
+		numFailed += check(dw == referenceDw, "the weight gradients without noise differ from the reference" + name);
+		numFailed += check(db == referenceDb, "the bias gradient without noise differs from the reference" + name);
+
+		double maxNoise = 0.0;
+		for (int i = 0; i < numSamples; i++) {
+			vector<double> sampleDw;
+			double sampleDb;
+			referenceGradients(w, b, vector<vector<double>>{ x[i] }, vector<int>{ y[i] }, c, sampleDw, &sampleDb);
+			double norm = 0.0;
+			for (double value : sampleDw)
+				norm += value * value;
+			maxNoise += sqrt(norm) * noiseFactor / numSamples;
+		}
+		computeGradients(w, b, x, y, batch, c, dw, &db, noiseRng, noiseFactor);
+		numFailed += check(db == referenceDb, "the bias gradient with noise differs from the reference" + name);
+		for (int j = 0; j < numFeatures; j++)
+			numFailed += check(fabs(dw[j] - referenceDw[j]) <= maxNoise + 1e-9,
+				"the noise of weight gradient " + to_string(j) + " exceeds its bound" + name);
+	}
+	return numFailed;
+}
+
+/**
+ * @brief SVMSGDClassifier::fit against the reference SGD steps, weights and bias, with one training sample.
+ *
+ * With one sample every epoch draws it, so each epoch has to subtract the learning rate times the reference
+ * gradients from the weights and from the bias.
+ *
+ * @return Number of failed checks.
+ */
+static int testSGDFit() {
+	int numFailed = 0;
+	Xoshiro128PlusPlus rng(3);
+
+	for (int t = 0; t < 500; t++) {
+		int numFeatures = 1 + rng() % 12;
+		unsigned int epochs = 1 + rng() % 10;
+		vector<double> w(numFeatures);
+		for (auto& value : w)
+			value = randomReal(rng, -3, 3);
+		double b = randomReal(rng, -2, 2), c = randomReal(rng, 0.5, 1), learningRate = randomReal(rng, 0.001, 0.1);
+		vector<vector<double>> x(1, vector<double>(numFeatures));
+		for (auto& value : x[0])
+			value = randomReal(rng, 0, 10);
+		vector<int> y = { rng() % 2 ? 1 : -1 };
+		string name = " (case " + to_string(t) + ")";
+
+		SVMSGDClassifier svm(c, epochs, t, learningRate);
+		svm.setWeights(w, b);
+		svm.fit(x, y);
+
+		for (unsigned int e = 0; e < epochs; e++) {
+			vector<double> dw;
+			double db;
+			referenceGradients(w, b, x, y, c, dw, &db);
+			for (int j = 0; j < numFeatures; j++)
+				w[j] = w[j] - (learningRate * dw[j]);
+			b = b - (learningRate * db);
+		}
+
+		// The bias is the opposite of the decision value of the zero sample, and each weight adds to it for its unit sample:
+		vector<float> sample(numFeatures, 0.0f);
+		numFailed += check(svm.decisionValue(sample) == -b, "the bias after fit differs from the reference" + name);
+		for (int j = 0; j < numFeatures; j++) {
+			sample[j] = 1.0f;
+			numFailed += check(svm.decisionValue(sample) == w[j] - b,
+				"weight " + to_string(j) + " after fit differs from the reference" + name);
+			sample[j] = 0.0f;
+		}
+	}
+	return numFailed;
+}
+
+/**
+ * @brief Generate a trace of instructions that mostly stride, with some jumps, some alternating strides and some
+ * instructions that repeat their address.
+ * @param numAccesses Number of accesses of the trace.
+ * @param numInstructions Number of instructions of the trace.
+ * @param seed Seed of the trace.
+ * @return The trace.
+ */
+static AccessesDataset<L64bu, L64bu> makeStridedTrace(int numAccesses, int numInstructions, unsigned int seed) {
+	AccessesDataset<L64bu, L64bu> res;
+	Xoshiro128PlusPlus rng(seed);
+	vector<L64bu> addresses(numInstructions);
+	for (int i = 0; i < numInstructions; i++)
+		addresses[i] = 0x7ff000000000ull + i * 0x100000ull;
+
+	for (int k = 0; k < numAccesses; k++) {
+		int i = rng() % numInstructions;
+		L64bu stride = 8 * (1 + i % 4);
+		if (rng() % 10 == 0)
+			stride = 64 * (rng() % 5);
+		else if (i % 5 == 0 && (k / 7) % 2)
+			stride = 16;
+		else if (i % 7 == 1)
+			stride = 0;
+		addresses[i] += stride;
+		res.accessesInstructions.push_back(0x400000 + i * 0x13 + ((i % 3) << 12));
+		res.accesses.push_back(addresses[i]);
+	}
+	return res;
+}
+
+/**
+ * @brief HashOnHashDFCM against a reference DFCM of unbounded maps, access by access.
+ *
+ * The reference keeps the last access and the hash of the deltas of each instruction, and the delta that followed
+ * each hash. Every access is predicted and then fitted, so fit reuses the slots probed by predict. The Infinite
+ * tables and Real tables with room for every instruction and hash have to issue the same predictions.
+ *
+ * @return Number of failed checks.
+ */
+static int testDFCMReference() {
+	int numFailed = 0;
+	AccessesDataset<L64bu, L64bu> data = makeStridedTrace(100000, 64, 5);
+	HashOnHashDFCM<L64bu, L64b> infinite(HistoryCacheType::Infinite);
+	HashOnHashDFCM<L64bu, L64b> real(HistoryCacheType::Real, { 8, 8, -1, true }, { 14, 16, -1, true }, false);
+	vector<pair<string, HashOnHashDFCM<L64bu, L64b>*>> models = { { "Infinite", &infinite }, { "Real", &real } };
+
+	for (auto& model : models) {
+		unordered_map<L64bu, pair<L64bu, L64bu>> instrHashTable; // Instruction -> (last access, hash).
+		unordered_map<L64bu, L64b> hashDeltaTable; // Hash -> delta.
+		int numMismatches = 0;
+
+		for (size_t i = 0; i < data.accesses.size(); i++) {
+			L64bu instruction = data.accessesInstructions[i], access = data.accesses[i];
+			auto entry = instrHashTable.find(instruction);
+			bool isReferencePredicted = false;
+			L64bu referenceAccess = 0;
+			if (entry != instrHashTable.end()) {
+				auto deltaEntry = hashDeltaTable.find(entry->second.second);
+				isReferencePredicted = deltaEntry != hashDeltaTable.end();
+				if (isReferencePredicted)
+					referenceAccess = entry->second.first + deltaEntry->second;
+			}
+
+			L64bu predictedAccess = 0;
+			bool isPredicted = model.second->predict(instruction, &predictedAccess);
+			if (isPredicted != isReferencePredicted || (isPredicted && predictedAccess != referenceAccess))
+				numMismatches++;
+			model.second->fit(instruction, access);
+
+			if (entry != instrHashTable.end()) {
+				L64b delta = access - entry->second.first;
+				hashDeltaTable[entry->second.second] = delta;
+				entry->second = { access, entry->second.second ^ (L64bu)delta };
+			}
+			else {
+				instrHashTable[instruction] = { access, 0 };
+			}
+		}
+		numFailed += check(numMismatches == 0, to_string(numMismatches) + " predictions of the " + model.first +
+			" HashOnHashDFCM differ from the reference");
+	}
+	return numFailed;
+}
+
+/**
+ * @brief DCPT and GHB against a reference that correlates the deltas of every instruction, access by access.
+ *
+ * The reference keeps all the accesses of each instruction, and correlates its last deltas (up to the number of deltas
+ * of the predictor), so an instruction with fewer deltas than that is only correlated over the ones it has. The
+ * Infinite DCPT, a Real DCPT with room for every instruction and a GHB whose buffer holds the whole trace have to
+ * issue the same predictions.
+ *
+ * @return Number of failed checks.
+ */
+static int testCorrelationReference() {
+	int numFailed = 0;
+	AccessesDataset<L64bu, L64bu> data = makeStridedTrace(50000, 64, 7);
+
+	for (int numDeltas : { 3, 4, 8 }) {
+		CorrelationPredictor<L64bu, L64b> infinite(HistoryCacheType::Infinite, { 0, 1, numDeltas, true });
+		CorrelationPredictor<L64bu, L64b> real(HistoryCacheType::Real, { 8, 8, numDeltas, true });
+		CorrelationPredictor<L64bu, L64b> globalHistoryBuffer(HistoryCacheType::Infinite, { 0, 1, numDeltas, true },
+			{ 16, 1, -1, true }, true);
+		vector<pair<string, CorrelationPredictor<L64bu, L64b>*>> models = { { "Infinite DCPT", &infinite },
+			{ "Real DCPT", &real }, { "GHB", &globalHistoryBuffer } };
+
+		for (auto& model : models) {
+			unordered_map<L64bu, vector<L64bu>> instructionAccesses;
+			int numMismatches = 0;
+
+			for (size_t i = 0; i < data.accesses.size(); i++) {
+				L64bu instruction = data.accessesInstructions[i], access = data.accesses[i];
+				vector<L64bu>& accesses = instructionAccesses[instruction];
+
+				// The last deltas of the instruction, oldest first, and the delta after the most recent earlier pair:
+				vector<L64b> deltas;
+				for (size_t k = accesses.size() > (size_t)numDeltas ? accesses.size() - numDeltas : 1; k < accesses.size(); k++)
+					deltas.push_back(accesses[k] - accesses[k - 1]);
+				bool isReferencePredicted = false;
+				L64bu referenceAccess = 0;
+				int n = (int)deltas.size();
+				for (int j = n - 2; j >= 1 && n >= 3 && !isReferencePredicted; j--) {
+					if (deltas[j] == deltas[n - 1] && deltas[j - 1] == deltas[n - 2]) {
+						isReferencePredicted = true;
+						referenceAccess = accesses.back() + deltas[j + 1];
+					}
+				}
+
+				L64bu predictedAccess = 0;
+				bool isPredicted = model.second->predict(instruction, &predictedAccess);
+				if (isPredicted != isReferencePredicted || (isPredicted && predictedAccess != referenceAccess))
+					numMismatches++;
+				model.second->fit(instruction, access);
+				accesses.push_back(access);
+			}
+			numFailed += check(numMismatches == 0, to_string(numMismatches) + " predictions of the " + model.first +
+				" with " + to_string(numDeltas) + " deltas differ from the reference");
+		}
+	}
+	return numFailed;
+}
+
+/**
+ * @brief Check the memory costs reported by a DFCM, with or without the tag and LRU bits.
+ * @param name Name of the geometry.
+ * @param model The DFCM.
+ * @param withTags Whether the costs include the tag and LRU bits (getTotalMemoryCosts) or not (getMemoryCosts).
+ * @param expectedFirstTableCost Expected cost of the first table, in bytes.
+ * @param expectedSecondTableCost Expected cost of the second table, in bytes.
+ * @return Number of failed checks.
+ */
+template<typename Model>
+static int checkDFCMMemoryCosts(const string& name, Model& model, bool withTags, double expectedFirstTableCost,
+	double expectedSecondTableCost) {
+	double firstTableCost, secondTableCost;
+	double cost = withTags ? model.getTotalMemoryCosts(&firstTableCost, &secondTableCost) :
+		model.getMemoryCosts(&firstTableCost, &secondTableCost);
+	string description = name + (withTags ? " with" : " without") + " tags: reported " + to_string(firstTableCost) +
+		" + " + to_string(secondTableCost) + " bytes instead of " + to_string(expectedFirstTableCost) + " + " +
+		to_string(expectedSecondTableCost);
+	return check(firstTableCost == expectedFirstTableCost && secondTableCost == expectedSecondTableCost &&
+		cost == expectedFirstTableCost + expectedSecondTableCost, description);
+}
+
+/**
+ * @brief Memory costs of the DFCM tables for some Real and Infinite geometries, with and without tag and LRU bits.
+ *
+ * A Real table of 2^numIndexBits sets of numWays entries costs, per entry, the last access (8 bytes) and its history
+ * (the bits of each element), plus 64 - numIndexBits tag bits and 1 LRU bit if these are counted. An Infinite table
+ * has no tags, and costs the same per entry it holds.
+ *
+ * @return Number of failed checks.
+ */
+static int testDFCMMemoryCosts() {
+	int numFailed = 0;
+
+	// 16 sets x 2 ways with a last access and a hash, and 32 sets x 2 ways with a delta (61 and 60 tag and LRU bits):
+	HashOnHashDFCM<L64bu, L64b> hashOnHash(HistoryCacheType::Real, { 4, 2, -1, true }, { 5, 2, -1, true }, false);
+	numFailed += checkDFCMMemoryCosts("Real HashOnHashDFCM", hashOnHash, false, 32 * 16, 64 * 8);
+	numFailed += checkDFCMMemoryCosts("Real HashOnHashDFCM", hashOnHash, true, 32 * (16 + 61 / 8.0), 64 * (8 + 60 / 8.0));
+
+	// A 2-bit confidence counter in each entry of the second table:
+	hashOnHash.setConfidence(2, 1);
+	numFailed += checkDFCMMemoryCosts("Real HashOnHashDFCM with confidence", hashOnHash, false, 32 * 16, 64 * (8 + 2 / 8.0));
+	numFailed += checkDFCMMemoryCosts("Real HashOnHashDFCM with confidence", hashOnHash, true, 32 * (16 + 61 / 8.0),
+		64 * (8 + 62 / 8.0));
+
+	// The first table of a 3-order DFCM keeps the last access, 3 deltas and their hash:
+	KOrderDFCM<L64bu, L64b> kOrder(HistoryCacheType::Real, { 4, 2, 3, true }, { 5, 2, -1, true }, false);
+	numFailed += checkDFCMMemoryCosts("Real KOrderDFCM", kOrder, false, 32 * 40, 64 * 8);
+	numFailed += checkDFCMMemoryCosts("Real KOrderDFCM", kOrder, true, 32 * (40 + 61 / 8.0), 64 * (8 + 60 / 8.0));
+
+	// Two instructions (0, 8, 16, 24 and 100, 116) leave 2 entries in the first table, and hashes 0 and 8 in the second:
+	HashOnHashDFCM<L64bu, L64b> infinite(HistoryCacheType::Infinite);
+	vector<pair<L64bu, L64bu>> accesses = { { 1, 0 }, { 2, 100 }, { 1, 8 }, { 1, 16 }, { 2, 116 }, { 1, 24 } };
+	for (auto& access : accesses)
+		infinite.fit(access.first, access.second);
+	numFailed += checkDFCMMemoryCosts("Infinite HashOnHashDFCM", infinite, false, 2 * 16, 2 * 8);
+	numFailed += checkDFCMMemoryCosts("Infinite HashOnHashDFCM", infinite, true, 2 * 16, 2 * 8);
+	return numFailed;
+}
+
+/**
+ * @brief Run a test, printing whether it passed.
+ * @param name Name of the test.
+ * @param test The test, which returns its number of failed checks.
+ * @return Number of failed checks.
+ */
+static int runTest(const string& name, int (*test)()) {
+	int numFailed = test();
+	std::cout << name << ": " << (numFailed == 0 ? "OK" : to_string(numFailed) + " checks FAILED") << std::endl;
+	return numFailed;
+}
+
+int runSelfTests() {
+	int numFailed = 0;
+	numFailed += runTest("computeGradients", testComputeGradients);
+	numFailed += runTest("SVMSGDClassifier::fit", testSGDFit);
+	numFailed += runTest("DFCM reference", testDFCMReference);
+	numFailed += runTest("DFCM memory costs", testDFCMMemoryCosts);
+	numFailed += runTest("DCPT and GHB reference", testCorrelationReference);
+	return numFailed;
+}
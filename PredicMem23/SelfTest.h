@@ -0,0 +1,33 @@
+/////////////////////////////////////////////////////////////////////////////////
+/// @file SelfTest.h
+/// @brief Declaration of the regression tests of the simulator.
+///
+/// This file declares the entry point of the regression tests run by "PredicMem23 --selftest",
+/// which check the optimized models against reference implementations of them.
+///
+/// @section LICENSE
+/// Copyright (c) 2024 Pablo Snchez Cuevas
+///
+/// This file is part of PredicMem23.
+///
+/// PredicMem23 is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+///
+/// PredicMem23 is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with PredicMem23. If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/**
+ * @brief Run all the regression tests, printing the result of each one.
+ * @return Number of failed checks (0 if every test passes).
+ */
+int runSelfTests();
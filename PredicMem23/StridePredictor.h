@@ -0,0 +1,347 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//    Copyright (c) 2024  Pablo Snchez Cuevas                    //
+//                                                                             //
+//    This file is part of PredicMem23.                                            //
+//                                                                             //
+//    PredicMem23 is free software: you can redistribute it and/or modify          //
+//    it under the terms of the GNU General Public License as published by     //
+//    the Free Software Foundation, either version 3 of the License, or        //
+//    (at your option) any later version.                                      //
+//                                                                             //
+//    PredicMem23 is distributed in the hope that it will be useful,               //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the              //
+//    GNU General Public License for more details.                             //
+//                                                                             //
+//    You should have received a copy of the GNU General Public License        //
+//    along with PredicMem23. If not, see <
+// http://www.gnu.org/licenses/>.
+//
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <iostream>
+#include "BuffersSimulator.h"
+#include "Global.h"
+#include "PredictorModel.h"
+#include "PrefetchCacheSimulator.h"
+
+using namespace std;
+
+/**
+ * @brief StridePredictor Class that implements the classic PC-indexed stride predictors.
+ *
+ * Each entry of the stride table keeps the last access of its instruction and two fields: the stride and either a
+ * saturating confidence counter (stride predictor with confidence) or the last delta (two-delta stride predictor,
+ * whose stride only changes when the same delta is seen twice in a row). The predicted access is the last access
+ * plus the stride. They are cheap baselines for the DFCM and SVM predictors.
+ *
+ * @tparam T Type of instruction and access data.
+ * @tparam Delta Type representing the delta between two accesses.
+ */
+template<typename T, typename Delta>
+class StridePredictor : public PredictorModel<T, int> {
+protected:
+    int numPartsToPrint = 10000; /**< Number of parts to print during simulation for progress tracking. */
+    AccessesDataset<T, T> data; /**< The dataset of accesses. */
+
+    HistoryCacheEntry<T, Delta, T>* tableEntry = nullptr; /**< Entry of the last probed instruction (nullptr if missing). */
+    T probedInstruction = 0; /**< Instruction of the last probe. */
+    bool isProbeValid = false; /**< Whether the entry of the last probe still points to the current table slot. */
+
+    /**
+     * @brief Probe the stride table for an instruction, keeping a reference to the slot found.
+     *
+     * predict and fit of the same access share this probe, and the table is updated in place through the reference.
+     *
+     * @param instruction The instruction to look up.
+     */
+    void probeTable(T instruction) {
+        this->tableEntry = this->strideTable->findEntry(instruction);
+        this->probedInstruction = instruction;
+        this->isProbeValid = true;
+    }
+
+    /**
+     * @brief Get the maximum value of the confidence counters.
+     * @return The maximum confidence.
+     */
+    Delta getMaxConfidence() {
+        return ((Delta)1 << this->numConfidenceBits) - 1;
+    }
+
+    /**
+     * @brief Get the number of bits of the stride fields of an entry (besides the tag, LRU and last access bits).
+     * @return The number of bits.
+     */
+    double getEntryFieldsNumBits() {
+        double strideNumBits = sizeof(Delta) * 8;
+        return strideNumBits + (this->isTwoDelta ? strideNumBits : this->numConfidenceBits);
+    }
+
+public:
+    long numHits = 0; /**< Number of hits during simulation. */
+    double hitRate = 0.0; /**< The hit rate during simulation. */
+
+    shared_ptr<HistoryCache<T, T, Delta, T>> strideTable; /**< The stride table (history: stride and confidence or last delta). */
+
+    HistoryCacheType historyCacheType; /**< Type of history cache (Infinite or Real). */
+    CacheParameters tableCacheParams = {}; /**< Cache parameters for the stride table. */
+
+    bool isTwoDelta = false; /**< Whether the stride is confirmed by two equal deltas instead of by a confidence counter. */
+    int numConfidenceBits = 2; /**< Number of bits of the saturating confidence counters. */
+    int confidenceThreshold = 2; /**< Minimum confidence for a prediction to be issued. */
+
+    bool countMemoryCapacity = false; /**< Flag to determine if memory costs are calculated. */
+    shared_ptr<PrefetchCacheSimulator<T>> prefetchSimulator = nullptr; /**< Data caches fed with the predictions as prefetches (nullptr if not simulated). */
+
+    /**
+     * @brief Constructor for initializing the model with the cache parameters of its table.
+     *
+     * @param historyCacheType The type of the history cache (Infinite or Real).
+     * @param tableCacheParams Parameters for the stride table.
+     * @param isTwoDelta Whether the predictor is a two-delta stride predictor.
+     * @param countTotalMemoryCost Flag to count memory costs or not.
+     */
+    StridePredictor(HistoryCacheType historyCacheType, CacheParameters tableCacheParams = {}, bool isTwoDelta = false,
+        bool countTotalMemoryCost = true) {
+        this->historyCacheType = historyCacheType;
+        this->tableCacheParams = tableCacheParams;
+        this->isTwoDelta = isTwoDelta;
+        initializePredictor();
+        this->countMemoryCapacity = !countTotalMemoryCost;
+    }
+
+    /**
+     * @brief Destructor for cleaning up resources.
+     */
+    ~StridePredictor() {
+        clean();
+    }
+
+    /**
+     * @brief Clean up resources and reset state.
+     */
+    void clean() {
+        this->strideTable->clean();
+        this->data = {};
+        this->isProbeValid = false;
+    }
+
+    /**
+     * @brief Import a new access dataset.
+     *
+     * @param data The access dataset to import.
+     * @param datasetClases The dataset of classes (not used in this function).
+     */
+    void importData(AccessesDataset<T, T>& data, BuffersDataset<int>& datasetClases) {
+        this->data = data;
+    }
+
+    /**
+     * @brief Write the state of the stride table into a binary snapshot.
+     *
+     * @param os Output stream of the snapshot.
+     */
+    void save(ostream& os) {
+        this->strideTable->save(os);
+    }
+
+    /**
+     * @brief Restore the state of the stride table from a binary snapshot written by save.
+     *
+     * @param is Input stream of the snapshot.
+     */
+    void load(istream& is) {
+        this->strideTable->load(is);
+        this->isProbeValid = false;
+    }
+
+    /**
+     * @brief Initialize the stride table based on the history cache type.
+     */
+    void initializePredictor() {
+        if (historyCacheType == HistoryCacheType::Infinite) {
+            this->strideTable = shared_ptr<HistoryCache<T, T, Delta, T>>(
+                new InfiniteHistoryCache<T, T, Delta, T>(2, 1));
+        }
+        else if (historyCacheType == HistoryCacheType::Real) {
+            this->strideTable = shared_ptr<HistoryCache<T, T, Delta, T>>(
+                new RealHistoryCache<T, T, Delta, T>(
+                    this->tableCacheParams.numIndexBits,
+                    this->tableCacheParams.numWays, 2, 1));
+        }
+        else {
+            this->strideTable = nullptr;
+        }
+
+        // The fields of the history are costed by the predictor (see getEntryFieldsNumBits):
+        if (this->strideTable != nullptr)
+            this->strideTable->setNumBitsPerClass(0);
+        this->isProbeValid = false;
+    }
+
+    /**
+     * @brief Train the predictor with an instruction and its access.
+     *
+     * @param instruction The instruction to train on.
+     * @param access The access value associated with the instruction.
+     */
+    void fit(T instruction, T access) {
+        // The slot found by the prediction of this access is reused, unless the table was not probed for it:
+        if (!this->isProbeValid || this->probedInstruction != instruction)
+            probeTable(instruction);
+        this->isProbeValid = false;
+
+        if (this->tableEntry == nullptr) {
+            this->strideTable->updateEntry(instruction, nullptr, access, 0);
+            auto entry = this->strideTable->findEntry(instruction);
+            entry->setHistoryValue(0, 0);
+            entry->setHistoryValue(1, 0);
+            return;
+        }
+
+        Delta delta = access - this->tableEntry->getLastAccess();
+        Delta stride = this->tableEntry->peekHistory()[0];
+        Delta field = this->tableEntry->peekHistory()[1];
+        if (this->isTwoDelta) {
+            if (delta == field)
+                stride = delta;
+            field = delta;
+        }
+        else if (delta == stride) {
+            field = min(field + 1, getMaxConfidence());
+        }
+        else {
+            // The stride is only replaced once its confidence is exhausted:
+            if (field > 0)
+                field--;
+            if (field == 0)
+                stride = delta;
+        }
+
+        this->strideTable->updateEntry(instruction, this->tableEntry, access, 0);
+        this->tableEntry->setHistoryValue(0, stride);
+        this->tableEntry->setHistoryValue(1, field);
+    }
+
+    /**
+     * @brief Predict the access for a given instruction.
+     *
+     * @param instruction The instruction to predict for.
+     * @param access Pointer to store the predicted access value.
+     * @param instrIsInTable Pointer to indicate if the instruction is in the stride table.
+     * @return True if a prediction is issued, false otherwise.
+     */
+    bool predict(T instruction, T* access, bool* instrIsInTable) {
+        probeTable(instruction);
+        *instrIsInTable = this->tableEntry != nullptr;
+        if (!(*instrIsInTable))
+            return false;
+
+        const vector<Delta>& history = this->tableEntry->peekHistory();
+        if (!this->isTwoDelta && history[1] < this->confidenceThreshold)
+            return false;
+
+        *access = this->tableEntry->getLastAccess() + history[0];
+        return true;
+    }
+
+    /**
+     * @brief Simplified prediction method.
+     *
+     * @param instruction The instruction to predict for.
+     * @param access Pointer to store the predicted access value.
+     * @return True if a prediction is issued, false otherwise.
+     */
+    bool predict(T instruction, T* access) {
+        bool dummyInstr;
+        return predict(instruction, access, &dummyInstr);
+    }
+
+    /**
+     * @brief Simulate the predictor on the dataset.
+     *
+     * @param initialize Whether to initialize the predictor before simulation.
+     * @return Shared pointer to a structure containing prediction results and costs.
+     */
+    shared_ptr<PredictResultsAndCosts> simulate(bool initialize = true) {
+        StridePredictResultsAndCosts resultsAndCosts;
+        double numTableMisses = 0.0;
+        double numPredictions = 0.0;
+
+        if (initialize) {
+            this->initializePredictor();
+        }
+        if (this->prefetchSimulator != nullptr) {
+            if (initialize) this->prefetchSimulator->reset();
+            else this->prefetchSimulator->resetCounters();
+        }
+
+        numHits = 0;
+        hitRate = 0.0;
+
+        for (int i = 0; i < data.accesses.size(); i++) {
+            T input = data.accessesInstructions[i];
+            T output = data.accesses[i];
+            T predictedOutput = 0;
+            bool instrIsInTable;
+            bool isPredicted = predict(input, &predictedOutput, &instrIsInTable);
+
+            if (!instrIsInTable) numTableMisses++;
+            if (isPredicted) {
+                numPredictions++;
+                if (output == predictedOutput) numHits++;
+            }
+
+            fit(input, output);
+
+            // Once trained with this access, the next access of the instruction is predicted and prefetched:
+            if (this->prefetchSimulator != nullptr) {
+                this->prefetchSimulator->access(output);
+                T prefetchedOutput;
+                if (predict(input, &prefetchedOutput))
+                    this->prefetchSimulator->prefetch(prefetchedOutput);
+            }
+
+            if (i % numPartsToPrint == 0) {
+                std::cout << input << " -> " << output << " vs " << predictedOutput << std::endl;
+                std::cout << "Hit rate: " << static_cast<double>(numHits) / (i + 1)
+                    << " ; " << static_cast<double>(i) / data.accesses.size() << std::endl;
+            }
+        }
+
+        hitRate = static_cast<double>(numHits) / data.accesses.size();
+
+        resultsAndCosts.hitRate = hitRate;
+        resultsAndCosts.coverage = numPredictions / data.accesses.size();
+        resultsAndCosts.accuracy = numPredictions > 0 ? numHits / numPredictions : 0.0;
+        resultsAndCosts.tableMissRate = numTableMisses / data.accesses.size();
+        resultsAndCosts.totalMemoryCost = this->countMemoryCapacity ? getMemoryCost() : getTotalMemoryCost();
+        if (this->prefetchSimulator != nullptr)
+            resultsAndCosts.prefetch = this->prefetchSimulator->getResults();
+        return shared_ptr<PredictResultsAndCosts>((PredictResultsAndCosts*)
+            new StridePredictResultsAndCosts(resultsAndCosts));
+    }
+
+    /**
+     * @brief Calculate the total memory cost, including tags and LRU bits.
+     *
+     * @return Total memory cost in bytes.
+     */
+    double getTotalMemoryCost() {
+        return this->strideTable->getTotalMemoryCost() + getEntryFieldsNumBits() * this->strideTable->getNumEntries() / 8.0;
+    }
+
+    /**
+     * @brief Calculate the memory cost, excluding tags and LRU bits.
+     *
+     * @return Memory cost in bytes.
+     */
+    double getMemoryCost() {
+        return this->strideTable->getMemoryCost() + getEntryFieldsNumBits() * this->strideTable->getNumEntries() / 8.0;
+    }
+};
@@ -98,6 +98,7 @@ public:
 		t.filename = filename;
 		t.file = ifstream(filename);
 		t.file.open(filename);
+		t.currentLine = 0; // The new file is read from its beginning.
 	}
 
 	/**
@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include "Experimentation.h"
+#include "SelfTest.h"
 
 int main(int argc, char* argv[])
 {
@@ -39,6 +40,10 @@ int main(int argc, char* argv[])
 
     string inputSpecsFilePath = string(argv[1]);
 
+    // "--selftest" runs the regression tests of the models instead of the experiments of an input file:
+    if (inputSpecsFilePath == "--selftest")
+        return runSelfTests() == 0 ? 0 : 1;
+
     TracePredictExperimentation::performAndExportExperimentations(inputSpecsFilePath);
 
 }
@@ -26,7 +26,9 @@
 #include <iostream>
 #include <string>
 #include <time.h>
+#include <limits>
 #include "SVMClassifier.hpp"
+#include "Global.h"
 
 MultiSVMClassifier::MultiSVMClassifier() {
     this->numClasses = 0;
@@ -38,40 +40,283 @@ MultiSVMClassifier::MultiSVMClassifier() {
 
 }
 
-MultiSVMClassifier::MultiSVMClassifier(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate){
+MultiSVMClassifier::MultiSVMClassifier(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate,
+    unsigned int seed){
     // MultiSVMClassifierType type) {
 
     this->numFeatures = numFeatures;
     this->numClasses = numClasses;
     this->c = c;
     this->epochs = epochs;
-    this->seed = rand();
+    this->seed = seed;
+    this->rng.seed(seed);
     this->learningRate = learningRate;
 
 }
 
-MultiSVMClassifierOneToAll::MultiSVMClassifierOneToAll() : MultiSVMClassifier() {}
+template<typename W>
+MultiSVMClassifierOneToAllT<W>::MultiSVMClassifierOneToAllT() : MultiSVMClassifier() {}
 
 MultiSVMClassifierOneToOne::MultiSVMClassifierOneToOne() : MultiSVMClassifier() {}
 
-MultiSVMClassifierOneToAll::MultiSVMClassifierOneToAll(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate)
-    : MultiSVMClassifier(numFeatures, numClasses, c, epochs, learningRate) {
+template<typename W>
+MultiSVMClassifierOneToAllT<W>::MultiSVMClassifierOneToAllT(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate,
+    unsigned int seed)
+    : MultiSVMClassifier(numFeatures, numClasses, c, epochs, learningRate, seed) {
 
+    // The binary classifiers only keep their hyperparameters, as their weights are stored in the matrix:
     for (int i = 0; i < numClasses; i++) {
-        auto model = SVMSGDClassifier::SVMSGDClassifier(c, epochs, rand(), learningRate);
-        model.initWeights(this->numFeatures);
+        auto model = SVMSGDClassifier::SVMSGDClassifier(c, epochs, this->rng(), learningRate);
         this->SVMsTable.push_back(model);
     }
+    initWeights(this->numFeatures);
         
 }
 
-MultiSVMClassifierOneToOne::MultiSVMClassifierOneToOne(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate)
-    : MultiSVMClassifier(numFeatures, numClasses, c, epochs, learningRate) {
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::initWeights(int numFeatures) {
+    // The classes are padded to a cache line of weights, so that every row of the matrix is aligned:
+    int numClassesPerLine = 64 / sizeof(W);
+    this->classStride = ((this->numClasses + numClassesPerLine - 1) / numClassesPerLine) * numClassesPerLine;
+
+    // Same initial values as SVMSGDClassifier::initWeights (the padding is kept to 0):
+    this->weights = AlignedWeightVector((size_t)numFeatures * this->classStride, Format::quantize(0.0));
+    for (int j = 0; j < numFeatures; j++)
+        for (int k = 0; k < this->numClasses; k++)
+            this->weights[(size_t)j * this->classStride + k] = Format::quantize(0.5);
+    this->biases = AlignedWeightVector(this->classStride, Format::quantize(0.0));
+    this->input = AlignedWeightVector(numFeatures, Format::quantize(0.0));
+    this->accumulators = vector<Accumulator, AlignedAllocator<Accumulator>>(this->classStride, 0);
+    this->scores = AlignedDoubleVector(this->classStride, 0.0);
+    this->gradientCoefficients = AlignedDoubleVector(this->classStride, 0.0);
+    resetMemoization();
+}
+
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::resetMemoization() {
+    this->classVersions = vector<unsigned int>(this->classStride, 1);
+    this->modelVersion = 1;
+    std::fill(this->memoClassVersions.begin(), this->memoClassVersions.end(), 0);
+    std::fill(this->memoModelVersions.begin(), this->memoModelVersions.end(), 0);
+}
+
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::enableMemoization(size_t numHistories) {
+    // A table of the same size is kept, since its entries are only valid with the current versions:
+    if (this->memoPredictions.size() == numHistories && this->memoScores.size() == numHistories * this->classStride)
+        return;
+    this->memoScores = AlignedDoubleVector(numHistories * this->classStride, 0.0);
+    this->memoClassVersions = vector<unsigned int>(numHistories * this->classStride, 0);
+    this->memoPredictions = vector<int>(numHistories, 0);
+    this->memoModelVersions = vector<unsigned long long>(numHistories, 0);
+}
+
+template<typename W>
+int MultiSVMClassifierOneToAllT<W>::predictMemoized(size_t history, span<const float> x) {
+    // Common case: the model has not been updated since the prediction of this history:
+    if (this->memoModelVersions[history] == this->modelVersion)
+        return this->memoPredictions[history];
+
+    // Otherwise, only the classes updated since then are scored again (with the same sums as computeScores):
+    double* memoScores = this->memoScores.data() + history * this->classStride;
+    unsigned int* memoVersions = this->memoClassVersions.data() + history * this->classStride;
+    const W* w = this->weights.data();
+    int numColumns = this->classStride;
+    bool isInputQuantized = false;
+    for (int k = 0; k < this->numClasses; k++) {
+        if (memoVersions[k] != this->classVersions[k]) {
+            if (!isInputQuantized) {
+                quantizeInput(x);
+                isInputQuantized = true;
+            }
+            Accumulator acc = 0;
+            for (size_t j = 0; j < this->input.size(); j++)
+                acc += (Accumulator)w[j * numColumns + k] * (Accumulator)this->input[j];
+            memoScores[k] = Format::accumulatorToReal(acc) - Format::toReal(this->biases[k]);
+            memoVersions[k] = this->classVersions[k];
+        }
+        this->scores[k] = memoScores[k];
+    }
+
+    this->memoPredictions[history] = bestClassFromScores();
+    this->memoModelVersions[history] = this->modelVersion;
+    return this->memoPredictions[history];
+}
+
+template<typename W>
+template<typename X>
+void MultiSVMClassifierOneToAllT<W>::quantizeInput(span<const X> x) {
+    if (this->input.size() != x.size())
+        this->input.resize(x.size());
+    for (size_t j = 0; j < x.size(); j++)
+        this->input[j] = Format::quantize((double)x[j]);
+}
+
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::computeScores() {
+    Accumulator* acc = this->accumulators.data();
+    double* s = this->scores.data();
+    const W* w = this->weights.data();
+    const W* b = this->biases.data();
+    int numColumns = this->classStride;
+
+    for (int k = 0; k < numColumns; k++)
+        acc[k] = 0;
+
+    // One pass over the features, updating the dot products of all the classes at once. Each class has its own
+    // lane, so the kernel is vectorized over the classes without changing the order of the sums of any class:
+    for (size_t j = 0; j < this->input.size(); j++) {
+        const W* row = w + j * numColumns;
+        Accumulator xj = (Accumulator)this->input[j];
+#pragma omp simd
+        for (int k = 0; k < numColumns; k++)
+            acc[k] += (Accumulator)row[k] * xj;
+    }
+
+    for (int k = 0; k < numColumns; k++)
+        s[k] = Format::accumulatorToReal(acc[k]) - Format::toReal(b[k]);
+}
+
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::computeSparseScores(span<const int> features) {
+    Accumulator* acc = this->accumulators.data();
+    double* s = this->scores.data();
+    const W* w = this->weights.data();
+    const W* b = this->biases.data();
+    int numColumns = this->classStride;
+    Accumulator one = (Accumulator)Format::quantize(1.0);
+
+    for (int k = 0; k < numColumns; k++)
+        acc[k] = 0;
+
+    // Same kernel as computeScores, only over the rows of the active features:
+    for (int f : features) {
+        const W* row = w + (size_t)f * numColumns;
+#pragma omp simd
+        for (int k = 0; k < numColumns; k++)
+            acc[k] += (Accumulator)row[k] * one;
+    }
+
+    for (int k = 0; k < numColumns; k++)
+        s[k] = Format::accumulatorToReal(acc[k]) - Format::toReal(b[k]);
+}
+
+template<typename W>
+int MultiSVMClassifierOneToAllT<W>::bestClassFromScores() {
+    const double* s = this->scores.data();
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    // The distance of the classes that are not predicted against the rest is not taken into account:
+    double bestDistance = infinity;
+#pragma omp simd reduction(min:bestDistance)
+    for (int k = 0; k < this->numClasses; k++) {
+        double distance = s[k] < 0 ? -s[k] : infinity;
+        bestDistance = distance < bestDistance ? distance : bestDistance;
+    }
+    if (bestDistance == infinity)
+        return 0;
+
+    // As in predict, the first class at the minimum distance is chosen:
+    for (int k = 0; k < this->numClasses; k++) {
+        if (s[k] < 0 && -s[k] == bestDistance)
+            return k;
+    }
+    return 0;
+}
+
+template<typename W>
+template<typename X>
+int MultiSVMClassifierOneToAllT<W>::predictSample(span<const X> x) {
+    quantizeInput(x);
+    computeScores();
+    return bestClassFromScores();
+}
+
+template<typename W>
+template<typename X>
+void MultiSVMClassifierOneToAllT<W>::fitSample(span<const X> x, int label) {
+    W* w = this->weights.data();
+    W* b = this->biases.data();
+    double* coefficients = this->gradientCoefficients.data();
+    int numColumns = this->classStride;
+
+    quantizeInput(x);
+    for (unsigned int t = 1; t <= this->epochs; t++) {
+        computeScores();
+
+        // Hinge loss of each classifier (its class is labelled as -1, and the rest as +1):
+        for (int k = 0; k < this->numClasses; k++) {
+            int y = k == label ? -1 : +1;
+            double distance = 1 - y * this->scores[k];
+            coefficients[k] = distance <= 0 ? 0.0 : this->c * y;
+        }
+        invalidateClasses(coefficients);
+
+        // Same SGD step of SVMSGDClassifier::fit for all the classifiers, in one pass over the features
+        // (the updated weights are rounded and saturated to their format):
+        for (size_t j = 0; j < this->input.size(); j++) {
+            W* row = w + j * numColumns;
+            double xj = Format::toReal(this->input[j]);
+#pragma omp simd
+            for (int k = 0; k < this->numClasses; k++) {
+                double weight = Format::toReal(row[k]);
+                double gradient = weight * (1 - this->c);
+                if (coefficients[k] != 0.0)
+                    gradient = gradient - (coefficients[k] * xj);
+                row[k] = Format::quantize(weight - (this->learningRate * gradient));
+            }
+        }
+        for (int k = 0; k < this->numClasses; k++)
+            b[k] = Format::quantize(Format::toReal(b[k]) - (this->learningRate * coefficients[k]));
+    }
+}
+
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::fitClass(W* w, W& b, const W* x, int label) {
+    Accumulator dot_product = 0;
+    for (int j = 0; j < this->numFeatures; j++)
+        dot_product += (Accumulator)w[j] * (Accumulator)x[j];
+
+    double distance = 1 - label * (Format::accumulatorToReal(dot_product) - Format::toReal(b));
+    for (int j = 0; j < this->numFeatures; j++) {
+        double weight = Format::toReal(w[j]);
+        double gradient = weight * (1 - this->c);
+        if (distance > 0)
+            gradient = gradient - (this->c * label * Format::toReal(x[j]));
+        w[j] = Format::quantize(weight - (this->learningRate * gradient));
+    }
+    b = Format::quantize(Format::toReal(b) - (this->learningRate * (distance > 0 ? this->c * label : 0.0)));
+}
+
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::save(ostream& os) {
+    MultiSVMClassifier::save(os);
+    writeBinary(os, this->classStride);
+    writeBinaryVector(os, this->weights);
+    writeBinaryVector(os, this->biases);
+}
+
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::load(istream& is) {
+    MultiSVMClassifier::load(is);
+    readBinary(is, this->classStride);
+    readBinaryVector(is, this->weights);
+    readBinaryVector(is, this->biases);
+    this->input = AlignedWeightVector(this->numFeatures, Format::quantize(0.0));
+    this->accumulators = vector<Accumulator, AlignedAllocator<Accumulator>>(this->classStride, 0);
+    this->scores = AlignedDoubleVector(this->classStride, 0.0);
+    this->gradientCoefficients = AlignedDoubleVector(this->classStride, 0.0);
+    resetMemoization();
+}
+
+MultiSVMClassifierOneToOne::MultiSVMClassifierOneToOne(int numFeatures, int numClasses, double c, unsigned int epochs, double learningRate,
+    unsigned int seed)
+    : MultiSVMClassifier(numFeatures, numClasses, c, epochs, learningRate, seed) {
 
     for (int i = 0; i < numClasses; i++)
         for (int j = 0; j < numClasses; j++) {
             if (j >= i) {
-                auto model = SVMSGDClassifier::SVMSGDClassifier(c, epochs, rand(), learningRate);
+                auto model = SVMSGDClassifier::SVMSGDClassifier(c, epochs, this->rng(), learningRate);
                 model.initWeights(this->numFeatures);
                 this->SVMsTable.push_back(model);
 
@@ -91,91 +336,327 @@ void MultiSVMClassifier::initWeights(int numFeatures) {
         svm.initWeights(numFeatures);
 }
 
+void MultiSVMClassifier::save(ostream& os) {
+    writeBinary(os, this->numFeatures);
+    writeBinary(os, this->numClasses);
+    writeBinary(os, this->seed);
+    writeBinary(os, (int)this->SVMsTable.size());
+    for (auto& svm : this->SVMsTable)
+        svm.save(os);
+}
 
-void MultiSVMClassifierOneToAll::fit(vector<vector<double>> & data, vector<int> & label) {
-    
-    // For each classifier, we build the real-label vector fpr the entirety of given data:
-    for (int k = 0; k < SVMsTable.size(); k++) {
-        vector<int> realLabels = vector<int>();
-        if (label.size() > 1) {
-            std::transform(label.begin(), label.end(), realLabels.begin(),
-                [k](int c) {return k == c ? -1 : +1; });
-        }
-        else realLabels = vector<int>{ k == label[0]? -1 : +1 };
+void MultiSVMClassifier::load(istream& is) {
+    int numFeatures, numClasses, numSVMs;
+    readBinary(is, numFeatures);
+    readBinary(is, numClasses);
+    if (numFeatures != this->numFeatures || numClasses != this->numClasses) {
+        string msg = "ERROR: The snapshot does not match the parameters of the classifier!\n";
+        std::cout << msg;
+        throw std::invalid_argument(msg);
+    }
+
+    readBinary(is, this->seed);
+    readBinary(is, numSVMs);
+    this->SVMsTable = vector<SVMSGDClassifier>(numSVMs);
+    for (auto& svm : this->SVMsTable)
+        svm.load(is);
+}
+
+
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::fit(vector<vector<double>> & data, vector<int> & label) {
 
-        // Then, we fit each classifier with the resulting real-label vector:
-        SVMsTable[k].fit(data, realLabels);
+    if (data.size() == 1) {
+        fitSample(span<const double>(data[0]), label[0]);
+        return;
     }
 
+    // The samples are quantized once, and the classifiers are trained in parallel. Each one draws the samples as
+    // SVMSGDClassifier::fit does, labelling its class as -1, on a private copy of its column of the weight matrix
+    // (the columns of the classes are interleaved in the same cache lines):
+    size_t numFeatures = this->numFeatures;
+    AlignedWeightVector samples(data.size() * numFeatures);
+    for (size_t i = 0; i < data.size(); i++)
+        for (size_t j = 0; j < numFeatures; j++)
+            samples[i * numFeatures + j] = Format::quantize(data[i][j]);
+
+    int numClassifiers = (int)SVMsTable.size();
+    size_t numColumns = this->classStride;
+#pragma omp parallel
+    {
+        AlignedWeightVector column(numFeatures);
+
+#pragma omp for schedule(dynamic,1)
+        for (int k = 0; k < numClassifiers; k++) {
+            for (size_t j = 0; j < numFeatures; j++)
+                column[j] = this->weights[j * numColumns + k];
+            W bias = this->biases[k];
+
+            Xoshiro128PlusPlus sampleRng(SVMsTable[k].seed);
+            for (unsigned int t = 1; t <= this->epochs; t++) {
+                unsigned int idx = sampleRng() % data.size();
+                fitClass(column.data(), bias, samples.data() + idx * numFeatures, k == label[idx] ? -1 : +1);
+            }
+
+            for (size_t j = 0; j < numFeatures; j++)
+                this->weights[j * numColumns + k] = column[j];
+            this->biases[k] = bias;
+        }
+    }
+
+    for (int k = 0; k < numClassifiers; k++)
+        invalidateClass(k);
 }
 
 void MultiSVMClassifierOneToOne::fit(vector<vector<double>>& data, vector<int>& label) {
 
-    // For each classifier, we build the real-label vector for the entirety of given data:
-    
-    for (int j = 0; j < this->numClasses; j++)
-        for (int k = 0; k < this->numClasses; k++) {
-            if (k > j) {
-                int class0 = j, class1 = k;
-                int predictorIndex = ((j * numClasses) + k);
-                vector<int> realLabels = vector<int>();
-                if (label.size() > 1) {
-                    std::transform(label.begin(), label.end(), realLabels.begin(),
-                        [class0, class1](int c) {
-                            int res = 0;
-                            if (c == class0) res = -1;
-                            else if(c == class1) res = +1;
-                            return res;
-                        });
-                }
-                else {
+    // The pairs of classes are trained in parallel (each binary classifier draws its samples from its own seed, so
+    // the results do not depend on the threads). Every thread builds the real labels of its pairs in its own vector:
+    int numPairs = this->numClasses * this->numClasses;
+#pragma omp parallel if(data.size() > 1)
+    {
+        vector<int> realLabels(label.size());
+
+#pragma omp for schedule(dynamic,1)
+        for (int predictorIndex = 0; predictorIndex < numPairs; predictorIndex++) {
+            int class0 = predictorIndex / this->numClasses, class1 = predictorIndex % this->numClasses;
+            if (class1 <= class0)
+                continue;
+
+            std::transform(label.begin(), label.end(), realLabels.begin(),
+                [class0, class1](int c) {
                     int res = 0;
-                    if (label[0] == class0) res = -1;
-                    else if(label[0] == class1) res = +1;
-                    realLabels = vector<int>{ res };
-                }
+                    if (c == class0) res = -1;
+                    else if (c == class1) res = +1;
+                    return res;
+                });
 
-                
+            // Then, we fit each classifier with the resulting real-label vector:
+            SVMsTable[predictorIndex].fit(data, realLabels);
+        }
+    }
+
+}
 
-                // Then, we fit each classifier with the resulting real-label vector:
-                SVMsTable[predictorIndex].fit(data, realLabels);
+
+template<typename W>
+int MultiSVMClassifierOneToAllT<W>::predictOne(span<const float> x) {
+    return predictSample(x);
+}
+
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::fitOne(span<const float> x, int label) {
+    fitSample(x, label);
+}
+
+int MultiSVMClassifierOneToOne::predictOne(span<const float> x) {
+    if (predictionsHistogram.size() != numClasses)
+        predictionsHistogram.resize(numClasses);
+    std::fill(predictionsHistogram.begin(), predictionsHistogram.end(), 0);
+
+    int maxPreds = -1;
+    int bestPred = -1;
+    for (int j = 0; j < this->numClasses; j++)
+        for (int k = j + 1; k < this->numClasses; k++) {
+            int predictorIndex = ((j * numClasses) + k);
+            int winnerClass = SVMsTable[predictorIndex].predictOne(x) == -1 ? j : k;
+
+            predictionsHistogram[winnerClass]++;
+            if (predictionsHistogram[winnerClass] > maxPreds) {
+                maxPreds = predictionsHistogram[winnerClass];
+                bestPred = winnerClass;
             }
         }
 
+    return bestPred;
 }
 
+void MultiSVMClassifierOneToOne::fitOne(span<const float> x, int label) {
+    for (int j = 0; j < this->numClasses; j++)
+        for (int k = j + 1; k < this->numClasses; k++) {
+            int res = 0;
+            if (label == j) res = -1;
+            else if (label == k) res = +1;
+            SVMsTable[(j * numClasses) + k].fitOne(x, res);
+        }
+}
 
-vector<int> MultiSVMClassifierOneToAll::predict(vector<vector<double>> & data) {
-    vector<int> predicted_labels;
+template<typename W>
+int MultiSVMClassifierOneToAllT<W>::predictSparse(span<const int> features) {
+    computeSparseScores(features);
+    return bestClassFromScores();
+}
 
-    vector<vector<int>> predictedLabelsPerPredictor;
-    vector<vector<double>> distancesPerPredictor;
-    // Each classifier gives its prediction for the given data:
-    for (int k = 0; k < SVMsTable.size(); k++) {
-        distancesPerPredictor.push_back(SVMsTable[k].computeDistanceToPlane(data));
-        predictedLabelsPerPredictor.push_back(SVMsTable[k].predict(data));
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::fitSparse(span<const int> features, int label) {
+    W* w = this->weights.data();
+    W* b = this->biases.data();
+    double* coefficients = this->gradientCoefficients.data();
+    int numColumns = this->classStride;
+
+    for (unsigned int t = 1; t <= this->epochs; t++) {
+        computeSparseScores(features);
+
+        // Hinge loss of each classifier (its class is labelled as -1, and the rest as +1):
+        for (int k = 0; k < this->numClasses; k++) {
+            int y = k == label ? -1 : +1;
+            double distance = 1 - y * this->scores[k];
+            coefficients[k] = distance <= 0 ? 0.0 : this->c * y;
+        }
+        invalidateClasses(coefficients);
+
+        // SGD step of fitSample over the rows of the active features (whose value is 1):
+        for (int f : features) {
+            W* row = w + (size_t)f * numColumns;
+#pragma omp simd
+            for (int k = 0; k < this->numClasses; k++) {
+                double weight = Format::toReal(row[k]);
+                double gradient = weight * (1 - this->c) - coefficients[k];
+                row[k] = Format::quantize(weight - (this->learningRate * gradient));
+            }
+        }
+        for (int k = 0; k < this->numClasses; k++)
+            b[k] = Format::quantize(Format::toReal(b[k]) - (this->learningRate * coefficients[k]));
     }
+}
 
-    // For each data sample, we append as label the first class which has been predicted against 
-    // the rest:
-    for (int i = 0; i < data.size(); i++) {
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::computeBatchCoefficients(size_t sample, int label) {
+    double* coefficients = this->batchCoefficients.data() + sample * this->classStride;
+
+    // Hinge loss of each classifier (its class is labelled as -1, and the rest as +1):
+    for (int k = 0; k < this->numClasses; k++) {
+        int y = k == label ? -1 : +1;
+        double distance = 1 - y * this->scores[k];
+        coefficients[k] = distance <= 0 ? 0.0 : this->c * y;
+    }
+}
+
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::fitBatch(span<const span<const float>> x, span<const int> labels) {
+    size_t numSamples = x.size();
+    int numColumns = this->classStride;
+    if (numSamples == 0)
+        return;
+    if (this->batchCoefficients.size() < numSamples * numColumns)
+        this->batchCoefficients.resize(numSamples * numColumns, 0.0);
+    if (this->batchGradients.size() < numColumns)
+        this->batchGradients.resize(numColumns, 0.0);
+
+    W* w = this->weights.data();
+    W* b = this->biases.data();
+    double* gradients = this->batchGradients.data();
+
+    for (unsigned int t = 1; t <= this->epochs; t++) {
+        // All the samples of the batch are scored with the same weights:
+        for (size_t i = 0; i < numSamples; i++) {
+            quantizeInput(x[i]);
+            computeScores();
+            computeBatchCoefficients(i, labels[i]);
+            invalidateClasses(this->batchCoefficients.data() + i * numColumns);
+        }
+
+        // Then, each row of the matrix is updated once with the average gradient of the batch:
+        for (size_t j = 0; j < this->input.size(); j++) {
+            for (int k = 0; k < numColumns; k++)
+                gradients[k] = 0.0;
+            for (size_t i = 0; i < numSamples; i++) {
+                const double* coefficients = this->batchCoefficients.data() + i * numColumns;
+                double xj = Format::toReal(Format::quantize((double)x[i][j]));
+#pragma omp simd
+                for (int k = 0; k < numColumns; k++)
+                    gradients[k] += coefficients[k] * xj;
+            }
+
+            W* row = w + j * numColumns;
+#pragma omp simd
+            for (int k = 0; k < this->numClasses; k++) {
+                double weight = Format::toReal(row[k]);
+                double gradient = weight * (1 - this->c) - gradients[k] / numSamples;
+                row[k] = Format::quantize(weight - (this->learningRate * gradient));
+            }
+        }
+
+        for (int k = 0; k < this->numClasses; k++) {
+            double gradient = 0.0;
+            for (size_t i = 0; i < numSamples; i++)
+                gradient += this->batchCoefficients[i * numColumns + k];
+            b[k] = Format::quantize(Format::toReal(b[k]) - (this->learningRate * gradient / numSamples));
+        }
+    }
+}
 
-        int bestPrediction = 0;
-        double bestDistance = -1;
+template<typename W>
+void MultiSVMClassifierOneToAllT<W>::fitSparseBatch(span<const span<const int>> features, span<const int> labels) {
+    size_t numSamples = features.size();
+    int numColumns = this->classStride;
+    if (numSamples == 0)
+        return;
+    if (this->batchCoefficients.size() < numSamples * numColumns)
+        this->batchCoefficients.resize(numSamples * numColumns, 0.0);
+    if (this->batchGradients.size() < this->weights.size())
+        this->batchGradients.resize(this->weights.size(), 0.0);
+    if (this->isBatchRow.size() < (size_t)this->numFeatures)
+        this->isBatchRow.resize(this->numFeatures, false);
+
+    W* w = this->weights.data();
+    W* b = this->biases.data();
+
+    for (unsigned int t = 1; t <= this->epochs; t++) {
+        for (size_t i = 0; i < numSamples; i++) {
+            computeSparseScores(features[i]);
+            computeBatchCoefficients(i, labels[i]);
+            invalidateClasses(this->batchCoefficients.data() + i * numColumns);
+        }
 
-        for (int k = 0; k < SVMsTable.size(); k++) {
-            if (predictedLabelsPerPredictor[k][i] == -1) {
-                if ((bestDistance == -1) || (distancesPerPredictor[k][i] < bestDistance)) {
-                    bestPrediction = k;
-                    bestDistance = distancesPerPredictor[k][i];
+        // The gradients are only summed over the rows of the active features (whose value is 1):
+        this->batchRows.clear();
+        for (size_t i = 0; i < numSamples; i++) {
+            const double* coefficients = this->batchCoefficients.data() + i * numColumns;
+            for (int f : features[i]) {
+                double* gradients = this->batchGradients.data() + (size_t)f * numColumns;
+                if (!this->isBatchRow[f]) {
+                    this->isBatchRow[f] = true;
+                    this->batchRows.push_back(f);
+                    for (int k = 0; k < numColumns; k++)
+                        gradients[k] = 0.0;
                 }
+#pragma omp simd
+                for (int k = 0; k < numColumns; k++)
+                    gradients[k] += coefficients[k];
             }
         }
 
-        predicted_labels.push_back(bestPrediction);
+        for (int f : this->batchRows) {
+            W* row = w + (size_t)f * numColumns;
+            const double* gradients = this->batchGradients.data() + (size_t)f * numColumns;
+#pragma omp simd
+            for (int k = 0; k < this->numClasses; k++) {
+                double weight = Format::toReal(row[k]);
+                double gradient = weight * (1 - this->c) - gradients[k] / numSamples;
+                row[k] = Format::quantize(weight - (this->learningRate * gradient));
+            }
+            this->isBatchRow[f] = false;
+        }
 
+        for (int k = 0; k < this->numClasses; k++) {
+            double gradient = 0.0;
+            for (size_t i = 0; i < numSamples; i++)
+                gradient += this->batchCoefficients[i * numColumns + k];
+            b[k] = Format::quantize(Format::toReal(b[k]) - (this->learningRate * gradient / numSamples));
+        }
     }
+}
+
+template<typename W>
+vector<int> MultiSVMClassifierOneToAllT<W>::predict(vector<vector<double>> & data) {
+    vector<int> predicted_labels;
 
+    // For each data sample, we append as label the closest class which has been predicted against 
+    // the rest:
+    for (int i = 0; i < data.size(); i++) {
+        predicted_labels.push_back(predictSample(span<const double>(data[i])));
+    }
 
     return predicted_labels;
 }
@@ -230,3 +711,8 @@ vector<int> MultiSVMClassifierOneToOne::predict(vector<vector<double>>& data) {
 
     return predicted_labels;
 }
+
+template class MultiSVMClassifierOneToAllT<double>;
+template class MultiSVMClassifierOneToAllT<float>;
+template class MultiSVMClassifierOneToAllT<int16_t>;
+template class MultiSVMClassifierOneToAllT<int8_t>;
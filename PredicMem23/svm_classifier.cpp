@@ -27,6 +27,7 @@
 #include <string>
 #include <time.h>
 #include "SVMClassifier.hpp"
+#include "Global.h"
 
 SVMClassifier::SVMClassifier() {
 
@@ -48,16 +49,32 @@ void SVMClassifier::setWeights(vector<double> w, double b) {
     this->b = b;
 }
 
+void SVMClassifier::save(ostream& os) {
+    writeBinaryVector(os, w);
+    writeBinary(os, b);
+    writeBinary(os, c);
+    writeBinary(os, epochs);
+    writeBinary(os, seed);
+}
+
+void SVMClassifier::load(istream& is) {
+    readBinaryVector(is, w);
+    readBinary(is, b);
+    readBinary(is, c);
+    readBinary(is, epochs);
+    readBinary(is, seed);
+}
+
 
 void SVMClassifier::fit(vector<vector<double>> & data, vector<int> & label) {
-    srand(seed);
+    Xoshiro128PlusPlus rng(seed);
     
     if(w.size() == 0)
         w.resize(data[0].size());
     
     for(unsigned int t = 1; t <= epochs; t++) {
 
-        unsigned int idx = rand() % data.size();
+        unsigned int idx = rng() % data.size();
 
         if (label[idx] != 0) {
             double nt = epochs == 1? 1 : 1 / (c * t);
@@ -109,6 +126,18 @@ SVMSGDClassifier::SVMSGDClassifier(double c, unsigned int epochs, unsigned int s
     this->learningRate = learningRate;
 }
 
+void SVMSGDClassifier::save(ostream& os) {
+    SVMClassifier::save(os);
+    writeBinary(os, learningRate);
+    writeBinary(os, gradientNoise);
+}
+
+void SVMSGDClassifier::load(istream& is) {
+    SVMClassifier::load(is);
+    readBinary(is, learningRate);
+    readBinary(is, gradientNoise);
+}
+
 void SVMSGDClassifier::initWeights(int numFeatures) {
     // w.resize(numFeatures + 1);
     w = vector<double>(numFeatures, 0.5);
@@ -156,98 +185,141 @@ vector<double> SVMSGDClassifier::computeDistanceToPlane(vector<vector<double>>&
 }
 
 #define RESOLUCION_RAND 1000
-#define FACTOR_RAND 0.1
 
-void computeGradients(vector<double>& w, double b, vector<vector<double>>& x, vector<int>& y, double c,
-    vector<double>& dw, double* pointer_db) {
-    vector<double> resultingGradient_w = vector<double>(w.size(), 0);
+/**
+ * @brief Compute the gradients of the hinge loss for a batch of samples in a single pass.
+ *
+ * The gradients of the samples are averaged into dw and *pointer_db, which are overwritten. dw is only resized if
+ * it does not have the size of w, so reusing it between calls does not allocate memory. When noiseFactor is not 0,
+ * each weight gradient of a sample is perturbed with a uniform noise in [-noiseFactor, noiseFactor] times the norm
+ * of the gradient of that sample.
+ * @param w Weights of the classifier.
+ * @param b Bias of the classifier.
+ * @param x Training data.
+ * @param y Labels of the training data.
+ * @param batch Indices of the samples of the batch.
+ * @param c Regularization parameter.
+ * @param dw Output weight gradients.
+ * @param pointer_db Output bias gradient.
+ * @param rng Generator of the noise.
+ * @param noiseFactor Relative magnitude of the noise (0 to disable it).
+ */
+void computeGradients(const vector<double>& w, double b, const vector<vector<double>>& x, const vector<int>& y,
+    span<const unsigned int> batch, double c, vector<double>& dw, double* pointer_db, Xoshiro128PlusPlus& rng,
+    double noiseFactor) {
+    const size_t numFeatures = w.size();
+    const double batchSize = (double)batch.size();
     double resultingGradient_b = 0.0;
 
-    // double cost = computeCost(w, x, y, c);
-    
-    for (int i = 0; i < x.size(); i++) {
-        vector<double> partialGradient_w = vector<double>(w.size(), 0);
-        double partialGradient_b = 0.0;
+    dw.resize(numFeatures);
+    fill(dw.begin(), dw.end(), 0.0);
+
+    for (unsigned int i : batch) {
+        const double* xi = x[i].data();
         double dot_product = 0;
-        vector<double> xi = x[i];
-        for (unsigned int j = 0; j < xi.size(); j++) {
+        for (size_t j = 0; j < numFeatures; j++) {
             dot_product += w[j] * xi[j];
         }
 
+        // A sample outside the margin only contributes with the regularization term:
         double distance = 1 - y[i] * (dot_product - b);
-        if (distance <= 0) {
-            for (unsigned int j = 0; j < xi.size(); j++) {
-                partialGradient_w[j] = w[j] * (1 - c);
-            }
-            partialGradient_b = 0.0;
-            // partialGradient_w = w;// vector<double>(w.size(), 0); // = w;
+        double hinge = distance <= 0 ? 0.0 : c * y[i];
 
-        }
-        else {
-
-            for (unsigned int j = 0; j < xi.size(); j++) {
-                partialGradient_w[j] = (w[j] * (1 - c)) - (c * y[i] * xi[j]);
-            }
-            partialGradient_b = c * y[i];
-        }
-
-        // We sum a small random vector:
         double norm = 0.0;
-        for (unsigned int j = 0; j < xi.size(); j++) {
-            norm += partialGradient_w[j] * partialGradient_w[j];
+        if (noiseFactor != 0.0) {
+            for (size_t j = 0; j < numFeatures; j++) {
+                double partialGradient_w = (w[j] * (1 - c)) - (hinge * xi[j]);
+                norm += partialGradient_w * partialGradient_w;
+            }
+            norm = sqrt(norm);
         }
-        norm = sqrt(norm);
 
-        for (unsigned int j = 0; j < xi.size(); j++) {
-            double r = ((double)(rand() % RESOLUCION_RAND)) / RESOLUCION_RAND;
-            r = (r - 0.5) * 2;
-            r = r * FACTOR_RAND;
-            // partialGradient_w[j] += norm * r;
+        if (norm == 0.0) {
+            #pragma omp simd
+            for (size_t j = 0; j < numFeatures; j++) {
+                dw[j] += ((w[j] * (1 - c)) - (hinge * xi[j])) / batchSize;
+            }
         }
-
-        for (unsigned int j = 0; j < xi.size(); j++) {
-            resultingGradient_w[j] += partialGradient_w[j] / x.size();
+        else {
+            for (size_t j = 0; j < numFeatures; j++) {
+                double r = ((double)(rng() % RESOLUCION_RAND)) / RESOLUCION_RAND;
+                r = (r - 0.5) * 2 * noiseFactor;
+                dw[j] += ((w[j] * (1 - c)) - (hinge * xi[j]) + norm * r) / batchSize;
+            }
         }
-        resultingGradient_b += partialGradient_b / x.size();
+        resultingGradient_b += hinge / batchSize;
     }
 
-    dw = resultingGradient_w;
     *pointer_db = resultingGradient_b;
 }
 
 void SVMSGDClassifier::fit(vector<vector<double>>& data, vector<int>& label) {
-    srand(seed);
+    Xoshiro128PlusPlus rng(seed);
 
     if (w.size() == 0)
         w.resize(data[0].size());
 
+    vector<double> gradient_w(w.size());
+    double gradient_b = 0.0;
     for (unsigned int t = 1; t <= epochs; t++) {
 
-        unsigned int idx = rand() % data.size();
+        unsigned int idx = rng() % data.size();
 
         if (label[idx] != 0) {
+            computeGradients(w, b, data, label, span<const unsigned int>(&idx, 1), c, gradient_w, &gradient_b, rng,
+                gradientNoise);
 
-            vector<double> xi = data[idx];
-            auto xi_ = vector<vector<double>>{ xi };
-            auto label_ = vector<int>{ label[idx] };
+            for (size_t j = 0; j < w.size(); j++) {
+                w[j] = w[j] - (this->learningRate * gradient_w[j]);
+            }
+            b = b - (this->learningRate * gradient_b);
+        }
+    }
+}
 
-            vector<double> gradient_w = vector<double>();
-            double gradient_b = 0.0;
-            computeGradients(w, b, xi_, label_, c, gradient_w, &gradient_b);
+void SVMSGDClassifier::fitOne(span<const float> x, int label) {
+    if (w.size() == 0)
+        w.resize(x.size());
 
-            for (int j = 0; j < w.size(); j++) {
-                w[j] = w[j] - (this->learningRate * gradient_w[j]);
+    // With a single sample, every epoch of fit draws it again (the random index is always 0), and the
+    // gradients of computeGradients are not averaged, so the weights can be updated in place:
+    for (unsigned int t = 1; t <= epochs; t++) {
+        if (label != 0) {
+            double dot_product = 0;
+            for (unsigned int j = 0; j < x.size(); j++) {
+                dot_product += w[j] * (double)x[j];
+            }
+
+            double distance = 1 - label * (dot_product - b);
+            double gradient_b = 0.0;
+            if (distance <= 0) {
+                for (unsigned int j = 0; j < x.size(); j++) {
+                    double gradient_w = w[j] * (1 - c);
+                    w[j] = w[j] - (this->learningRate * gradient_w);
+                }
+            }
+            else {
+                for (unsigned int j = 0; j < x.size(); j++) {
+                    double gradient_w = (w[j] * (1 - c)) - (c * label * (double)x[j]);
+                    w[j] = w[j] - (this->learningRate * gradient_w);
+                }
+                gradient_b = c * label;
             }
             b = b - (this->learningRate * gradient_b);
         }
-       
     }
+}
 
-    // for(unsigned int i = 0; i < w.size(); i++) {
-    //     cout << "w" << i << " = " << w[i] << endl;
-    // }
+double SVMClassifier::decisionValue(span<const float> x) {
+    double dot_product = 0;
+    for (unsigned int j = 0; j < x.size(); j++) {
+        dot_product += w[j] * (double)x[j];
+    }
+    return dot_product - b;
+}
 
-    // cout << endl;
+int SVMClassifier::predictOne(span<const float> x) {
+    return decisionValue(x) >= 0 ? 1 : -1;
 }
 
 vector<int> SVMClassifier::predict(vector<vector<double>> & data) {